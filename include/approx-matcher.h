@@ -0,0 +1,252 @@
+#ifndef APPROX_MATCHER_H
+#define APPROX_MATCHER_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "kernels.h"
+#include "tools.h"
+
+// Bit-parallel approximate matcher (Shift-And with errors, Wu-Manber). Every
+// seed and its reverse complement are packed into 64-bit words and searched
+// with up to `maxErrors` substitutions, or edits when indels are allowed, in
+// one pass. Cost grows with the number of seeds and errors rather than with
+// the number of enumerated variants. IUPAC codes in a seed are character
+// classes, so a degenerate seed costs one bit per position like any other.
+// A seed with too many literal combinations to orient up front
+// (maxOrientationChecks) has each hit oriented by the bases it matched.
+class ApproxMatcher {
+public:
+    static constexpr uint8_t maxErrors = 3;
+    static constexpr uint8_t maxSeedLength = 64;
+
+private:
+    struct Word {
+        std::array<uint64_t, 4> baseMasks = {0, 0, 0, 0}; // bit set where the seed accepts A/C/G/T
+        uint64_t startBits = 0; // first position of each seed
+        uint64_t endBits = 0;   // last position of each seed
+        std::array<uint16_t, 64> seedAtBit{}; // seed index by end bit
+    };
+
+    struct Seed {
+        std::string bases;
+        bool isForward = false;
+        bool orientByBases = false; // isForward is only a default, see emit()
+    };
+
+    struct Hit {
+        uint64_t start;
+        uint16_t length;
+        uint8_t distance;
+        bool isForward;
+        bool orientByBases;
+    };
+
+    std::vector<Word> words;
+    std::vector<Seed> seeds;
+    std::string canonicalFwd, canonicalRev;
+    uint16_t longestSeed = 0;
+    uint8_t errors = 0;
+    bool indels = false;
+
+    // IUPAC code to the bases it accepts, bit 0 = A, 1 = C, 2 = G, 3 = T; 0 if not a code
+    static uint8_t baseClass(char c) {
+        switch (c) {
+            case 'A': return 0b0001;
+            case 'C': return 0b0010;
+            case 'G': return 0b0100;
+            case 'T': return 0b1000;
+            case 'R': return 0b0101;
+            case 'Y': return 0b1010;
+            case 'M': return 0b0011;
+            case 'K': return 0b1100;
+            case 'S': return 0b0110;
+            case 'W': return 0b1001;
+            case 'H': return 0b1011;
+            case 'B': return 0b1110;
+            case 'V': return 0b0111;
+            case 'D': return 0b1101;
+            case 'N': return 0b1111;
+            default:  return 0;
+        }
+    }
+
+    // seq[0, bases.size()) spells bases, in either case
+    static bool sameBases(const std::string& bases, const char* seq) {
+        for (size_t i = 0; i < bases.size(); ++i) {
+            if (kernels::baseSymbols[static_cast<uint8_t>(seq[i])] != kernels::baseSymbols[static_cast<uint8_t>(bases[i])]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // length of the best alignment of `seed` ending at seq[end], not reaching before begin
+    uint16_t alignStart(const char* seq, uint64_t begin, uint64_t end, const Seed& seed,
+                        uint8_t distance) const;
+
+    // matched bases closer to canonicalFwd than to canonicalRev, as for enumerated variants
+    bool basesCloserToFwd(const char* seq, const Hit& hit) const {
+        std::string bases(hit.length, 'N');
+        for (uint16_t i = 0; i < hit.length; ++i) {
+            const uint8_t symbol = kernels::baseSymbols[static_cast<uint8_t>(seq[hit.start + i])];
+            if (symbol < 4) bases[i] = "ACGT"[symbol];
+        }
+        return isCloserToFwd(bases, canonicalFwd);
+    }
+
+    template <typename OnMatch>
+    void emit(const char* seq, const Hit& hit, OnMatch& onMatch) const {
+        bool isCanonical = (hit.length == canonicalFwd.size()) &&
+            (sameBases(canonicalFwd, seq + hit.start) || sameBases(canonicalRev, seq + hit.start));
+        bool isForward = hit.orientByBases ? basesCloserToFwd(seq, hit) : hit.isForward;
+        onMatch(hit.start, hit.length, isForward, isCanonical, hit.distance);
+    }
+
+public:
+    // seeds are (sequence, isForward) pairs, IUPAC codes allowed; false (inactive) if they do not fit
+    bool build(const std::vector<std::pair<std::string, bool>>& seedInfo, uint8_t maxDistance,
+               bool allowIndels, const std::string& canonicalFwd, const std::string& canonicalRev);
+
+    // 64-bit words build() packs the seeds into
+    static size_t countWords(const std::vector<std::pair<std::string, bool>>& seedInfo);
+
+    // true if this matcher is estimated to scan faster than an automaton of
+    // `automatonStates` states over the enumerated variants, build included
+    static bool cheaperThanAutomaton(size_t words, uint8_t maxDistance, uint64_t automatonStates);
+
+    bool isActive() const { return !seeds.empty(); }
+
+    uint16_t getLongestMatchSize() const { return longestSeed + (indels ? errors : 0); }
+
+    // Same contract as Trie::scan, plus the edit distance of each match:
+    // onMatch(start, length, isForward, isCanonical, distance) ordered by start,
+    // then length. One report per (start, length); when several seeds hit, the
+    // closest one sets the orientation. Non-ACGT bases never match. With indels
+    // a hit is kept only where its distance is a local minimum along the
+    // sequence, so one occurrence is not reported once per tolerated shift.
+    template <typename OnMatch>
+    void scan(const char* seq, uint64_t begin, uint64_t end, OnMatch&& onMatch) const {
+        if (seeds.empty()) return;
+        const uint8_t none = errors + 1;
+        const uint16_t maxLength = getLongestMatchSize();
+        const auto nextBase = kernels::active().nextBase;
+
+        std::vector<std::array<uint64_t, maxErrors + 1>> states(words.size());
+        std::vector<uint8_t> distances, prevDistances, lastDistances; // indels: at j, j - 1, j - 2
+        if (indels) {
+            distances.assign(seeds.size(), none);
+            prevDistances.assign(seeds.size(), none);
+            lastDistances.assign(seeds.size(), none);
+        }
+
+        std::vector<Hit> pending;
+        size_t flushed = 0;
+        auto byStart = [](const Hit& a, const Hit& b) {
+            return a.start != b.start ? a.start < b.start : a.length < b.length;
+        };
+        auto addHit = [&](const Hit& hit) {
+            for (size_t p = flushed; p < pending.size(); ++p) {
+                if (pending[p].start == hit.start && pending[p].length == hit.length) {
+                    if (hit.distance < pending[p].distance) pending[p] = hit;
+                    return;
+                }
+            }
+            pending.push_back(hit);
+        };
+        // with indels, the hit at j - 1 is decided once the distance at j is known
+        auto takeIndelHits = [&](uint64_t j) {
+            for (size_t s = 0; s < seeds.size(); ++s) {
+                uint8_t d = prevDistances[s];
+                if (d == none) continue;
+                if (d != 0 && (d > lastDistances[s] || d >= distances[s])) continue;
+                uint16_t length = d == 0 ? static_cast<uint16_t>(seeds[s].bases.size())
+                                         : alignStart(seq, begin, j - 1, seeds[s], d);
+                addHit({j - length, length, d, seeds[s].isForward, seeds[s].orientByBases});
+            }
+        };
+
+        for (uint64_t j = begin; j < end; ++j) {
+            const size_t pendingBefore = pending.size();
+            const uint8_t idx = kernels::baseSymbols[static_cast<uint8_t>(seq[j])];
+            if (idx > 3) {
+                for (auto& wordStates : states) wordStates.fill(0);
+                if (indels) std::fill(distances.begin(), distances.end(), none);
+            } else {
+                for (size_t w = 0; w < words.size(); ++w) {
+                    const Word& word = words[w];
+                    auto& r = states[w];
+                    const uint64_t mask = word.baseMasks[idx];
+                    uint64_t prevOld = r[0];
+                    r[0] = ((r[0] << 1) | word.startBits) & mask;
+                    for (uint8_t d = 1; d <= errors; ++d) {
+                        uint64_t old = r[d];
+                        uint64_t next = (((old << 1) | word.startBits) & mask) // match
+                                      | (prevOld << 1) | word.startBits;         // substitution
+                        if (indels) {
+                            next |= (r[d - 1] << 1) | prevOld; // deletion, insertion
+                        }
+                        r[d] = next;
+                        prevOld = old;
+                    }
+                }
+                if (indels) std::fill(distances.begin(), distances.end(), none);
+                for (size_t w = 0; w < words.size(); ++w) {
+                    const auto& r = states[w];
+                    for (uint64_t ends = r[errors] & words[w].endBits; ends; ends &= ends - 1) {
+                        const uint8_t bit = static_cast<uint8_t>(__builtin_ctzll(ends));
+                        const uint16_t s = words[w].seedAtBit[bit];
+                        uint8_t d = 0;
+                        while (!((r[d] >> bit) & 1)) ++d;
+                        if (indels) {
+                            distances[s] = d;
+                        } else {
+                            uint16_t length = static_cast<uint16_t>(seeds[s].bases.size());
+                            addHit({j + 1 - length, length, d, seeds[s].isForward, seeds[s].orientByBases});
+                        }
+                    }
+                }
+            }
+
+            if (indels) {
+                if (j > begin) takeIndelHits(j);
+                lastDistances.swap(prevDistances);
+                prevDistances.swap(distances); // refilled on the next base
+            }
+
+            if (pending.size() != pendingBefore) std::sort(pending.begin() + flushed, pending.end(), byStart);
+            // a start is final once every seed length starting there has ended
+            while (flushed < pending.size() && pending[flushed].start + maxLength + 1 <= j + 1) {
+                emit(seq, pending[flushed++], onMatch);
+            }
+            if (flushed == pending.size()) {
+                pending.clear();
+                flushed = 0;
+            }
+
+            // skip the rest of an N-run; every distance two bases back is unset there too
+            if (idx > 3) {
+                const uint64_t nextJ = nextBase(seq, j + 1, end);
+                if (nextJ > j + 1) {
+                    if (indels) std::fill(lastDistances.begin(), lastDistances.end(), none);
+                    j = nextJ - 1;
+                }
+            }
+        }
+
+        if (indels && end > begin) {
+            std::fill(distances.begin(), distances.end(), none);
+            takeIndelHits(end);
+            std::sort(pending.begin() + flushed, pending.end(), byStart);
+        }
+        for (; flushed < pending.size(); ++flushed) {
+            emit(seq, pending[flushed], onMatch);
+        }
+    }
+};
+
+#endif /* APPROX_MATCHER_H */
@@ -0,0 +1,114 @@
+#ifndef BUILTIN_MOTIFS_H
+#define BUILTIN_MOTIFS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// k-mer lookup tables for the repeat sets most runs use (vertebrate TTAGGG and
+// plant TTTAGGG at -x 0..2), generated at compile time. KmerTable points at
+// one of these instead of building its own when the loaded patterns match.
+namespace builtinMotifs {
+
+constexpr uint8_t MATCH = 1;
+constexpr uint8_t FORWARD = 2;
+constexpr uint8_t CANONICAL = 4;
+
+constexpr uint32_t encode(const char *bases, size_t k) {
+    uint32_t code = 0;
+    for (size_t i = 0; i < k; ++i) {
+        uint32_t base = bases[i] == 'A' ? 0 : bases[i] == 'C' ? 1 : bases[i] == 'G' ? 2 : 3;
+        code = (code << 2) | base;
+    }
+    return code;
+}
+
+constexpr uint32_t reverseComplement(uint32_t code, size_t k) {
+    uint32_t rc = 0;
+    for (size_t i = 0; i < k; ++i, code >>= 2) rc = (rc << 2) | (3 - (code & 3));
+    return rc;
+}
+
+constexpr uint8_t hamming(uint32_t a, uint32_t b, size_t k) {
+    uint8_t distance = 0;
+    for (size_t i = 0; i < k; ++i, a >>= 2, b >>= 2) distance += (a & 3) != (b & 3);
+    return distance;
+}
+
+template <size_t K>
+struct Table {
+    uint32_t fwdCode = 0; // canonicalFwd, the lexicographically smaller strand
+    uint8_t editDistance = 0;
+    uint32_t patternCount = 0;
+    std::array<uint8_t, size_t(1) << (2 * K)> flags{};
+};
+
+// canonicalFwd and canonicalRev seeds with every substitution variant up to
+// editDistance, as expandPatternsWithOrientation() would produce them
+template <size_t K>
+constexpr Table<K> makeTable(const char (&canonicalFwd)[K + 1], uint8_t editDistance) {
+    Table<K> table;
+    table.fwdCode = encode(canonicalFwd, K);
+    table.editDistance = editDistance;
+    const uint32_t revCode = reverseComplement(table.fwdCode, K);
+    for (uint32_t code = 0; code < table.flags.size(); ++code) {
+        uint8_t fwdDistance = hamming(code, table.fwdCode, K);
+        uint8_t revDistance = hamming(code, revCode, K);
+        if (fwdDistance > editDistance && revDistance > editDistance) continue;
+        table.flags[code] = MATCH | (fwdDistance <= editDistance ? FORWARD : 0) |
+                            (fwdDistance == 0 || revDistance == 0 ? CANONICAL : 0);
+        ++table.patternCount;
+    }
+    return table;
+}
+
+template <size_t K>
+constexpr bool strandsSeparate(const Table<K> &table) {
+    return hamming(table.fwdCode, reverseComplement(table.fwdCode, K), K) > 2 * table.editDistance;
+}
+
+inline constexpr Table<6> vertebrate0 = makeTable<6>("CCCTAA", 0);
+inline constexpr Table<6> vertebrate1 = makeTable<6>("CCCTAA", 1);
+inline constexpr Table<6> vertebrate2 = makeTable<6>("CCCTAA", 2);
+inline constexpr Table<7> plant0 = makeTable<7>("CCCTAAA", 0);
+inline constexpr Table<7> plant1 = makeTable<7>("CCCTAAA", 1);
+inline constexpr Table<7> plant2 = makeTable<7>("CCCTAAA", 2);
+
+// every variant has a single orientation, so the tables are unambiguous
+static_assert(strandsSeparate(vertebrate2) && strandsSeparate(plant2), "built-in strands overlap");
+
+template <size_t K>
+bool matches(const Table<K> &table, const std::vector<std::pair<std::string, bool>> &patternInfo,
+             const std::string &canonicalFwd, const std::string &canonicalRev) {
+    if (canonicalFwd.size() != K || canonicalRev.size() != K ||
+        canonicalFwd.find_first_not_of("ACGT") != std::string::npos ||
+        encode(canonicalFwd.data(), K) != table.fwdCode ||
+        encode(canonicalRev.data(), K) != reverseComplement(table.fwdCode, K) ||
+        patternInfo.size() != table.patternCount) {
+        return false;
+    }
+    for (const auto &[pattern, isForward] : patternInfo) {
+        if (pattern.size() != K || pattern.find_first_not_of("ACGT") != std::string::npos) return false;
+        uint8_t f = table.flags[encode(pattern.data(), K)];
+        if (!(f & MATCH) || ((f & FORWARD) != 0) != isForward) return false;
+    }
+    return true;
+}
+
+// built-in flag table equal to the one KmerTable would build, or nullptr
+inline const uint8_t *find(const std::vector<std::pair<std::string, bool>> &patternInfo,
+                           const std::string &canonicalFwd, const std::string &canonicalRev) {
+    for (const Table<6> *table : {&vertebrate0, &vertebrate1, &vertebrate2}) {
+        if (matches(*table, patternInfo, canonicalFwd, canonicalRev)) return table->flags.data();
+    }
+    for (const Table<7> *table : {&plant0, &plant1, &plant2}) {
+        if (matches(*table, patternInfo, canonicalFwd, canonicalRev)) return table->flags.data();
+    }
+    return nullptr;
+}
+
+} // namespace builtinMotifs
+
+#endif /* BUILTIN_MOTIFS_H */
@@ -36,8 +36,12 @@ struct UserInputTeloscope : UserInput {
 
     uint32_t windowSize = 1000;
     uint32_t step = 1000;
+    std::vector<uint32_t> windowLevels; // --window-levels: coarser non-overlapping windows, ascending
     uint32_t terminalLimit = 50000;
+    uint32_t adaptiveExtent = 0; // ultra-fast tips stop this far past the last sub-block once no chain is open (0 = full terminalLimit)
     uint8_t editDistance = 1;
+    bool indels = false; // -x also counts insertions and deletions
+    bool periodicScan = false; // match only inside tandem stretches of the canonical period
     uint8_t kmerLen = 21;
 
     unsigned short int maxMatchDist = 50;
@@ -0,0 +1,64 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Hot inner loops with one implementation per instruction set. The best set
+// supported by the running CPU is picked once at startup (or forced with
+// --kernel), so a generic build still uses AVX2/AVX-512 where available.
+namespace kernels {
+
+enum class Level : uint8_t { scalar, sse2, avx2, avx512 };
+
+constexpr uint8_t anchorStride = 8; // bytes reserved per anchor in findAnchor
+
+// Input byte to scan symbol: A=0, C=1, G=2, T=3 in either case, everything
+// else (N, IUPAC codes) 4. Scanners read soft-masked sequence through this
+// table instead of upper-casing a copy first.
+inline constexpr std::array<uint8_t, 256> baseSymbols = [] {
+    std::array<uint8_t, 256> symbols{};
+    for (auto &symbol : symbols) symbol = 4;
+    const char bases[] = "ACGT";
+    for (uint8_t b = 0; b < 4; ++b) {
+        symbols[static_cast<uint8_t>(bases[b])] = b;
+        symbols[static_cast<uint8_t>(bases[b] | 0x20)] = b;
+    }
+    return symbols;
+}();
+
+struct KernelSet {
+    Level level;
+    const char *name;
+    uint32_t vectorWidth; // bytes compared per vector step
+
+    // adds the A, C, G, T counts of seq[0, length) to counts, either case
+    void (*countBases)(const char *seq, uint64_t length, uint32_t counts[4]);
+    // expands BAM 4-bit packed bases (high nibble first) into length chars
+    void (*decodeBases)(const uint8_t *packed, uint64_t length, char *out);
+    // first p in [pos, end) where seq[p] is A, C, G or T in either case, else
+    // end; scanners use it to jump over N-runs and other non-ACGT stretches
+    uint64_t (*nextBase)(const char *seq, uint64_t pos, uint64_t end);
+    // bit i set when seq[pos + i] is A, C, G or T and equals seq[pos + i + period],
+    // either case, for i < 64 and pos + i + period < end
+    uint64_t (*periodMask)(const char *seq, uint64_t pos, uint64_t end, uint32_t period);
+    // first p in [pos, end - anchorLen] where one of the lowercase anchors
+    // starts, comparing seq case-insensitively, else end
+    uint64_t (*findAnchor)(const char *seq, uint64_t pos, uint64_t end,
+                           const char *anchors, uint32_t anchorCount, uint8_t anchorLen);
+};
+
+extern const KernelSet *current;
+
+inline const KernelSet &active() { return *current; }
+
+// "auto", "scalar", "sse2", "avx2" or "avx512"; false if unknown or not supported by this CPU
+bool select(const std::string &name);
+
+// comma-separated kernel names usable on this CPU
+std::string supported();
+
+} // namespace kernels
+
+#endif /* KERNELS_H */
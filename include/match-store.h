@@ -0,0 +1,188 @@
+#ifndef MATCH_STORE_H
+#define MATCH_STORE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct MatchInfo {
+    bool isCanonical = false;
+    bool isForward = false;
+    uint64_t position = 0;
+    uint16_t matchSize = 0;
+    bool isReported = false; // written by -m: canonical, or non-canonical near a sequence end
+    uint8_t distance = 0;    // edits from the seed; 0 unless the bit-parallel matcher found it
+};
+
+// Columnar list of matches in insertion order. Positions are stored as 32-bit
+// offsets from the start of their run (a new run begins when an offset would
+// not fit), size, edit distance and flags share one 16-bit word, and the
+// matched bases, when recorded, are an id into a dictionary of the distinct
+// sequences seen. A match costs 6 bytes, 10 with its sequence, instead of a
+// MatchInfo plus a std::string per hit. Consumers that need one strand or only
+// canonical matches read a View of the store rather than a copy of those matches.
+class MatchStore {
+    static constexpr unsigned distanceShift = 11;
+    static constexpr uint16_t distanceMask = 3 << distanceShift;
+    static constexpr uint16_t reportedBit = 1 << 13;
+    static constexpr uint16_t forwardBit = 1 << 14;
+    static constexpr uint16_t canonicalBit = 1 << 15;
+    static constexpr uint16_t sizeMask = (1 << distanceShift) - 1;
+
+    struct Run {
+        size_t first; // index of the first match in the run
+        uint64_t base;
+    };
+
+    std::vector<uint32_t> offsets;
+    std::vector<uint16_t> sizeFlags;
+    std::vector<uint32_t> sequenceIds; // empty unless sequences are recorded
+    std::vector<Run> runs;
+    std::vector<std::string> sequences;
+    std::unordered_map<std::string, uint32_t> sequenceIndex;
+    std::string lookupKey; // reused to intern without allocating per match
+
+    uint64_t baseOf(size_t index) const {
+        if (runs.size() == 1) return runs.front().base;
+        size_t lo = 0, hi = runs.size();
+        while (hi - lo > 1) {
+            size_t mid = (lo + hi) / 2;
+            if (runs[mid].first <= index) lo = mid;
+            else hi = mid;
+        }
+        return runs[lo].base;
+    }
+
+    void pushPosition(uint64_t position) {
+        if (runs.empty() || position < runs.back().base || position - runs.back().base > UINT32_MAX) {
+            runs.push_back({offsets.size(), position});
+        }
+        offsets.push_back(static_cast<uint32_t>(position - runs.back().base));
+    }
+
+    uint32_t intern(const std::string &sequence);
+
+public:
+    static constexpr size_t npos = SIZE_MAX;
+    static constexpr uint16_t maxMatchSize = sizeMask;
+    static constexpr uint8_t maxDistance = distanceMask >> distanceShift;
+
+    // matches whose flag bits equal `value` under `mask`, in store order
+    class View {
+        const MatchStore *store;
+        uint16_t mask, value;
+
+        bool contains(size_t index) const { return (store->sizeFlags[index] & mask) == value; }
+
+    public:
+        View(const MatchStore &store, uint16_t mask, uint16_t value) : store(&store), mask(mask), value(value) {}
+
+        const MatchStore &getStore() const { return *store; }
+
+        // first match at or after index, else npos
+        size_t next(size_t index) const {
+            while (index < store->size() && !contains(index)) ++index;
+            return index < store->size() ? index : npos;
+        }
+
+        // last match before index, else npos
+        size_t before(size_t index) const {
+            index = std::min(index, store->size());
+            while (index > 0) {
+                if (contains(--index)) return index;
+            }
+            return npos;
+        }
+
+        size_t first() const { return next(0); }
+
+        size_t last() const { return before(store->size()); }
+
+        size_t count() const {
+            size_t n = 0;
+            for (size_t i = 0; i < store->size(); ++i) n += contains(i);
+            return n;
+        }
+
+        MatchInfo operator[](size_t index) const { return (*store)[index]; }
+    };
+
+    View all() const { return View(*this, 0, 0); }
+    View forward() const { return View(*this, forwardBit, forwardBit); }
+    View reverse() const { return View(*this, forwardBit, 0); }
+    View canonical() const { return View(*this, canonicalBit, canonicalBit); }
+    View reported() const { return View(*this, reportedBit, reportedBit); }
+    View reportedNonCanonical() const { return View(*this, reportedBit | canonicalBit, reportedBit); }
+
+    size_t size() const { return offsets.size(); }
+
+    bool empty() const { return offsets.empty(); }
+
+    // drops every match, keeping the allocated capacity
+    void clear() {
+        offsets.clear();
+        sizeFlags.clear();
+        sequenceIds.clear();
+        runs.clear();
+        sequences.clear();
+        sequenceIndex.clear();
+    }
+
+    void reserve(size_t count) {
+        offsets.reserve(count);
+        sizeFlags.reserve(count);
+    }
+
+    // approximate heap bytes held, for the --max-memory budget
+    size_t memoryUsage() const;
+
+    void push_back(const MatchInfo &match) {
+        pushPosition(match.position);
+        sizeFlags.push_back(static_cast<uint16_t>((match.matchSize & sizeMask) |
+                                                  ((match.distance << distanceShift) & distanceMask) |
+                                                  (match.isReported ? reportedBit : 0) |
+                                                  (match.isForward ? forwardBit : 0) |
+                                                  (match.isCanonical ? canonicalBit : 0)));
+    }
+
+    // also records seq[0, matchSize), uppercased
+    void push_back(const MatchInfo &match, const char *seq);
+
+    uint64_t position(size_t index) const { return baseOf(index) + offsets[index]; }
+
+    MatchInfo operator[](size_t index) const {
+        MatchInfo match;
+        const uint16_t word = sizeFlags[index];
+        match.position = position(index);
+        match.matchSize = word & sizeMask;
+        match.distance = static_cast<uint8_t>((word & distanceMask) >> distanceShift);
+        match.isForward = (word & forwardBit) != 0;
+        match.isCanonical = (word & canonicalBit) != 0;
+        match.isReported = (word & reportedBit) != 0;
+        return match;
+    }
+
+    // matched bases of a match pushed with its sequence; undefined for others
+    const std::string &sequence(size_t index) const { return sequences[sequenceIds[index]]; }
+
+    // first index whose position is >= position; positions must be ascending
+    size_t lowerBound(uint64_t position) const;
+
+    // sorts matches [from, size()) by position, then size
+    void sortFrom(size_t from);
+
+    // appends the matches of a view, sequences included
+    void append(const View &view);
+
+    // appends every match to out as position, size/flag word and, when
+    // recorded, its bases; read back with deserialize
+    void serialize(std::string &out) const;
+
+    // appends the matches of a serialize output
+    void deserialize(const char *data, size_t bytes);
+};
+
+#endif /* MATCH_STORE_H */
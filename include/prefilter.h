@@ -0,0 +1,110 @@
+#ifndef PREFILTER_H
+#define PREFILTER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "kernels.h"
+
+// Exact prefilter for the motif scan. Every loaded pattern contains at least
+// one short anchor q-gram, so a stretch without anchors cannot hold a match.
+// Anchors are searched with the vector kernels and only the neighbourhoods
+// around them are handed to the exact matcher.
+class MotifPrefilter {
+public:
+    static constexpr size_t maxAnchors = 4;
+    static constexpr uint8_t maxAnchorLen = kernels::anchorStride;
+
+private:
+    std::vector<char> anchors; // maxAnchorLen bytes per anchor, lowercase
+    uint8_t anchorLen = 0;
+    uint16_t longestPattern = 0;
+
+public:
+    // false (prefilter inactive) when no anchor set is cheap and selective enough
+    bool build(const std::vector<std::pair<std::string, bool>> &patternInfo);
+
+    bool isActive() const { return anchorLen != 0; }
+
+    uint8_t getAnchorLen() const { return anchorLen; }
+
+    // first position p in [pos, end - anchorLen] where an anchor starts, else end
+    uint64_t nextAnchor(const char *seq, uint64_t pos, uint64_t end) const;
+
+    // Calls scanRange(from, to) on disjoint, ascending spans of [begin, end) that
+    // together contain every pattern occurrence lying inside [begin, end).
+    template <typename ScanRange>
+    void forEachCandidateSpan(const char *seq, uint64_t begin, uint64_t end, ScanRange &&scanRange) const {
+        const uint64_t before = longestPattern - anchorLen; // pattern bases left of an anchor
+        const uint64_t after = longestPattern;              // anchor start to pattern end
+
+        uint64_t anchor = nextAnchor(seq, begin, end);
+        while (anchor < end) {
+            uint64_t spanStart = anchor > begin + before ? anchor - before : begin;
+            uint64_t spanEnd = std::min(end, anchor + after);
+
+            // extend while the next anchor's neighbourhood overlaps this span
+            while (spanEnd < end) {
+                anchor = nextAnchor(seq, anchor + 1, end);
+                if (anchor >= end || anchor > spanEnd + before) break;
+                spanEnd = std::min(end, anchor + after);
+            }
+            if (spanEnd >= end) anchor = end;
+
+            scanRange(spanStart, spanEnd);
+        }
+    }
+};
+
+// Optional first stage (--periodic-scan). Telomeric arrays are tandem repeats
+// of the canonical period, so inside them most bases equal the base one period
+// downstream, while random sequence agrees at about a quarter of positions.
+// Blocks of 64 bases that agree at least half the time are padded and handed
+// on; the cost per base does not depend on the pattern set. Unlike
+// MotifPrefilter this is lossy: isolated motif hits outside such runs are not
+// scanned.
+class PeriodicityFilter {
+public:
+    static constexpr uint32_t blockSize = 64;    // positions per periodMask call
+    static constexpr uint32_t minAgreement = 32; // of blockSize; random sequence averages 16
+
+private:
+    uint32_t period = 0;
+    uint64_t padding = 0;
+
+public:
+    void build(uint32_t canonicalSize, uint16_t longestMatch) {
+        period = canonicalSize;
+        padding = blockSize + longestMatch; // ragged array edges and matches straddling a block
+    }
+
+    bool isActive() const { return period != 0; }
+
+    // Calls scanRange(from, to) on disjoint, ascending spans of [begin, end)
+    // around every block of high period self-similarity.
+    template <typename ScanRange>
+    void forEachCandidateSpan(const char *seq, uint64_t begin, uint64_t end, ScanRange &&scanRange) const {
+        const auto periodMask = kernels::active().periodMask;
+        uint64_t spanStart = 0, spanEnd = 0;
+        bool inSpan = false;
+        for (uint64_t block = begin; block < end; block += blockSize) {
+            if (__builtin_popcountll(periodMask(seq, block, end, period)) < minAgreement) continue;
+            uint64_t from = block > begin + padding ? block - padding : begin;
+            uint64_t to = std::min(end, block + blockSize + period + padding);
+            if (inSpan && from <= spanEnd) {
+                spanEnd = to;
+                continue;
+            }
+            if (inSpan) scanRange(spanStart, spanEnd);
+            spanStart = from;
+            spanEnd = to;
+            inSpan = true;
+        }
+        if (inSpan) scanRange(spanStart, spanEnd);
+    }
+};
+
+#endif /* PREFILTER_H */
@@ -2,7 +2,7 @@
 #define READ_FILTER_H
 
 #include <memory>
-#include <string>
+#include <string_view>
 
 struct UserInputTeloscope;
 class Teloscope;
@@ -13,7 +13,8 @@ class ReadTelomereFilter {
 public:
     explicit ReadTelomereFilter(const UserInputTeloscope &input);
     ~ReadTelomereFilter();
-    bool matches(std::string sequence);
+    // reads soft-masked or uppercase bases in place
+    bool matches(std::string_view sequence);
 };
 
 #endif /* READ_FILTER_H */
@@ -0,0 +1,88 @@
+#ifndef SPILL_FILE_H
+#define SPILL_FILE_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Scratch file next to the outputs for path results that are not needed
+// until the report is written: window metrics always, and matches once the
+// --max-memory budget is reached. Workers append extents as paths are walked
+// and the report reads them back one path at a time. The file is unlinked as
+// soon as it is opened and goes away with the process.
+class SpillFile {
+    std::string path;
+    std::fstream file;
+    uint64_t bytes = 0;
+    bool unlinked = false;
+    std::mutex mtx;
+
+    void open();
+
+public:
+    struct Extent {
+        uint64_t offset = 0;
+        uint64_t bytes = 0;
+    };
+
+    explicit SpillFile(std::string path) : path(std::move(path)) {}
+
+    ~SpillFile();
+
+    // thread-safe; the file is created on the first call
+    Extent append(const char *data, uint64_t size);
+
+    // reads the extent into data, which must hold extent.bytes
+    void read(const Extent &extent, char *data);
+
+    template <typename T>
+    Extent append(const std::vector<T> &records) {
+        return append(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(T));
+    }
+
+    // replaces the contents of records with the extents, in order
+    template <typename T>
+    void read(const std::vector<Extent> &extents, std::vector<T> &records) {
+        uint64_t total = 0;
+        for (const Extent &extent : extents) total += extent.bytes;
+        records.resize(total / sizeof(T));
+        char *data = reinterpret_cast<char *>(records.data());
+        for (const Extent &extent : extents) {
+            read(extent, data);
+            data += extent.bytes;
+        }
+    }
+};
+
+// Bytes of path results held in memory, shared by all workers. A path
+// reserves its estimated size as it grows; when a reservation would exceed
+// the limit the path spills instead. A limit of 0 is unbounded.
+class MemoryBudget {
+    uint64_t limit = 0;
+    std::atomic<uint64_t> used{0};
+
+public:
+    void setLimit(uint64_t bytes) { limit = bytes; }
+
+    bool bounded() const { return limit != 0; }
+
+    // false, and nothing reserved, if the bytes do not fit
+    bool reserve(uint64_t size) {
+        if (!bounded()) return true;
+        uint64_t current = used.load(std::memory_order_relaxed);
+        do {
+            if (current + size > limit) return false;
+        } while (!used.compare_exchange_weak(current, current + size, std::memory_order_relaxed));
+        return true;
+    }
+
+    void release(uint64_t size) {
+        if (bounded()) used.fetch_sub(size, std::memory_order_relaxed);
+    }
+};
+
+#endif /* SPILL_FILE_H */
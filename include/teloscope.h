@@ -3,7 +3,14 @@
 
 #include "input.h"
 #include "tools.h"
+#include "prefilter.h"
+#include "approx-matcher.h"
+#include "builtin-motifs.h"
+#include "match-store.h"
+#include "spill-file.h"
+#include "kernels.h"
 #include <iostream>
+#include <fstream>
 #include <map>
 #include <stdint.h>
 #include <vector>
@@ -11,17 +18,66 @@
 #include <string_view>
 #include <array>
 #include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+
+// Allocator for cache-line aligned tables.
+template <typename T, size_t Align>
+struct AlignedAllocator {
+    using value_type = T;
+    template <typename U> struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Align>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align))); }
+    void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(Align)); }
+
+    bool operator==(const AlignedAllocator&) const { return true; }
+    bool operator!=(const AlignedAllocator&) const { return false; }
+};
 
 class Trie {
     struct TrieNode {
         std::array<int32_t, 4> children = {-1, -1, -1, -1}; // A=0, C=1, G=2, T=3
+        std::array<int32_t, 4> next = {0, 0, 0, 0}; // automaton goto, filled by buildAutomaton()
+        int32_t fail = 0;         // longest proper suffix that is also a trie prefix
+        int32_t output = 0;       // nearest pattern end on the failure chain (0 = none)
+        uint16_t depth = 0;       // prefix length = match length at pattern ends
         bool isEndOfWord = false;
         bool isForward = false; // true if pattern is forward-oriented (closer to canonicalFwd)
         bool isCanonical = false; // true if pattern is exactly canonicalFwd or canonicalRev
     };
 
-    std::vector<TrieNode> nodes;          // contiguous node pool
+    struct PendingMatch {
+        uint64_t start;
+        uint16_t length;
+        uint32_t state;
+    };
+
+    static constexpr uint32_t symbols = 5; // A, C, G, T, N
+    static constexpr uint32_t REPORT = 1u << 31; // target state ends a pattern
+
+    std::vector<TrieNode> nodes;          // contiguous node pool, used while building
+
+    // Compiled automaton: transitions[state * symbols + symbol] holds the target
+    // row offset (target * symbols), with REPORT set when a pattern ends there.
+    std::vector<uint32_t, AlignedAllocator<uint32_t, 64>> transitions;
+    std::vector<uint64_t> endBits;        // per state, bit set if a pattern ends there
+    std::vector<uint64_t> forwardBits;    // per state, bit set if the pattern there is forward
+    std::vector<uint64_t> canonicalBits;  // per state, bit set if the pattern there is canonical
+    std::vector<uint32_t> outputs;        // per state, next pattern end on the failure chain (0 = none)
+    std::vector<uint16_t> depths;         // per state, match length
+
+    static bool testBit(const std::vector<uint64_t>& bits, uint32_t state) {
+        return (bits[state >> 6] >> (state & 63)) & 1;
+    }
     unsigned short int longestPatternSize = 0;
+    uint16_t shortestMatchSize = 0;
+    uint16_t longestMatchSize = 0;
 
     // nucleotide to index
     static int8_t charToIndex(char c) {
@@ -48,36 +104,176 @@ public:
             }
             current = nodes[current].children[idx];
         }
-        nodes[current].isEndOfWord = true;
-        nodes[current].isForward = isForward;
-        nodes[current].isCanonical = isCanonical;
+        if (current != 0) { // the root never reports a match
+            nodes[current].isEndOfWord = true;
+            nodes[current].isForward = isForward;
+            nodes[current].isCanonical = isCanonical;
+        }
         if (pattern.size() > longestPatternSize) {
             longestPatternSize = pattern.size();
         }
     }
 
-    // root index
-    int32_t getRoot() const { return 0; }
+    // Aho-Corasick: failure links, output links and a complete goto function
+    void buildAutomaton() {
+        std::vector<int32_t> queue;
+        queue.reserve(nodes.size());
+        shortestMatchSize = 0;
+        longestMatchSize = 0;
+
+        for (int8_t c = 0; c < 4; ++c) {
+            int32_t child = nodes[0].children[c];
+            nodes[0].next[c] = (child < 0) ? 0 : child;
+            if (child > 0) {
+                nodes[child].fail = 0;
+                nodes[child].depth = 1;
+                queue.push_back(child);
+            }
+        }
+
+        // BFS order guarantees fail targets are finished before their dependants
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int32_t node = queue[head];
+            TrieNode& current = nodes[node];
+            int32_t failNode = current.fail;
+            current.output = nodes[failNode].isEndOfWord ? failNode : nodes[failNode].output;
+
+            if (current.isEndOfWord) {
+                if (shortestMatchSize == 0 || current.depth < shortestMatchSize) shortestMatchSize = current.depth;
+                if (current.depth > longestMatchSize) longestMatchSize = current.depth;
+            }
+
+            for (int8_t c = 0; c < 4; ++c) {
+                int32_t child = current.children[c];
+                if (child < 0) {
+                    current.next[c] = nodes[failNode].next[c];
+                } else {
+                    current.next[c] = child;
+                    nodes[child].fail = nodes[failNode].next[c];
+                    nodes[child].depth = current.depth + 1;
+                    queue.push_back(child);
+                }
+            }
+        }
 
-    // child index or -1
-    int32_t getChild(int32_t nodeIdx, char ch) const {
-        int8_t idx = charToIndex(ch);
-        return (idx >= 0) ? nodes[nodeIdx].children[idx] : -1;
+        compile();
     }
 
-    // end of pattern
-    bool isEnd(int32_t nodeIdx) const {
-        return nodes[nodeIdx].isEndOfWord;
+    // flatten the goto function and per-state data into the scan layout
+    void compile() {
+        const uint32_t stateCount = static_cast<uint32_t>(nodes.size());
+        transitions.assign(static_cast<size_t>(stateCount) * symbols, 0);
+        endBits.assign((stateCount + 63) / 64, 0);
+        forwardBits.assign((stateCount + 63) / 64, 0);
+        canonicalBits.assign((stateCount + 63) / 64, 0);
+        outputs.assign(stateCount, 0);
+        depths.assign(stateCount, 0);
+
+        for (uint32_t state = 0; state < stateCount; ++state) {
+            const TrieNode& node = nodes[state];
+            for (uint32_t c = 0; c < 4; ++c) {
+                const uint32_t target = static_cast<uint32_t>(node.next[c]);
+                const TrieNode& targetNode = nodes[target];
+                bool reports = targetNode.isEndOfWord || targetNode.output != 0;
+                transitions[state * symbols + c] = target * symbols | (reports ? REPORT : 0);
+            }
+            transitions[state * symbols + 4] = 0; // N resets to the root
+            if (node.isEndOfWord) endBits[state >> 6] |= uint64_t(1) << (state & 63);
+            if (node.isForward) forwardBits[state >> 6] |= uint64_t(1) << (state & 63);
+            if (node.isCanonical) canonicalBits[state >> 6] |= uint64_t(1) << (state & 63);
+            outputs[state] = static_cast<uint32_t>(node.output);
+            depths[state] = node.depth;
+        }
     }
 
-    // forward-oriented
-    bool isForward(int32_t nodeIdx) const {
-        return nodes[nodeIdx].isForward;
+    size_t getStateCount() const { return nodes.size(); }
+
+    size_t getBytesPerState() const { return symbols * sizeof(uint32_t); }
+
+    size_t getTableBytes() const { return transitions.size() * sizeof(uint32_t); }
+
+    // largest power of two (up to 4096) dividing the transition table address
+    size_t getTableAlignment() const {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(transitions.data());
+        size_t alignment = 1;
+        while (alignment < 4096 && address % (alignment * 2) == 0) alignment *= 2;
+        return alignment;
     }
 
-    // canonical (exact fwd or rev)
-    bool isCanonical(int32_t nodeIdx) const {
-        return nodes[nodeIdx].isCanonical;
+    // Single left-to-right pass over seq[begin, end). Matches are reported as
+    // onMatch(start, length, isForward, isCanonical) ordered by start, then length,
+    // i.e. the order a per-position trie walk would produce. Matches crossing `end`
+    // are not reported.
+    template <typename OnMatch>
+    void scan(const char* seq, uint64_t begin, uint64_t end, OnMatch&& onMatch) const {
+        if (longestMatchSize == 0) return;
+        const uint32_t* next = transitions.data();
+        const auto nextBase = kernels::active().nextBase;
+        uint32_t row = 0; // current state * symbols
+
+        auto report = [&](uint64_t start, uint16_t length, uint32_t state) {
+            onMatch(start, length, testBit(forwardBits, state), testBit(canonicalBits, state));
+        };
+
+        if (shortestMatchSize == longestMatchSize) {
+            // equal lengths: at most one pattern ends per base, already in start order
+            for (uint64_t j = begin; j < end; ++j) {
+                const uint8_t symbol = kernels::baseSymbols[static_cast<uint8_t>(seq[j])];
+                if (symbol == 4) { // N-run: back to the root and on to the next base
+                    row = 0;
+                    j = nextBase(seq, j + 1, end) - 1;
+                    continue;
+                }
+                const uint32_t target = next[row + symbol];
+                row = target & ~REPORT;
+                if (target & REPORT) {
+                    report(j + 1 - longestMatchSize, longestMatchSize, row / symbols);
+                }
+            }
+            return;
+        }
+
+        // mixed lengths: hold matches until no shorter-start match can still appear
+        std::vector<PendingMatch> pending;
+        size_t flushed = 0;
+        auto byStart = [](const PendingMatch& a, const PendingMatch& b) {
+            return a.start != b.start ? a.start < b.start : a.length < b.length;
+        };
+
+        for (uint64_t j = begin; j < end; ++j) {
+            const uint8_t symbol = kernels::baseSymbols[static_cast<uint8_t>(seq[j])];
+            if (symbol == 4) { // pending matches are flushed at the next base
+                row = 0;
+                j = nextBase(seq, j + 1, end) - 1;
+                continue;
+            }
+            const uint32_t target = next[row + symbol];
+            row = target & ~REPORT;
+
+            if (target & REPORT) {
+                const uint32_t state = row / symbols;
+                uint32_t hit = testBit(endBits, state) ? state : outputs[state];
+                for (; hit != 0; hit = outputs[hit]) {
+                    pending.push_back({j + 1 - depths[hit], depths[hit], hit});
+                }
+                std::sort(pending.begin() + flushed, pending.end(), byStart);
+            }
+
+            // a start is final once every pattern length starting there has ended
+            while (flushed < pending.size() && pending[flushed].start + longestMatchSize <= j + 1) {
+                const PendingMatch& m = pending[flushed++];
+                report(m.start, m.length, m.state);
+            }
+            if (flushed == pending.size()) {
+                pending.clear();
+                flushed = 0;
+            }
+        }
+
+        for (; flushed < pending.size(); ++flushed) {
+            const PendingMatch& m = pending[flushed];
+            report(m.start, m.length, m.state);
+        }
     }
 
     unsigned short int getLongestPatternSize() const {
@@ -86,14 +282,104 @@ public:
 };
 
 
-struct MatchInfo {
-    bool isCanonical = false;
-    bool isForward = false;
-    uint64_t position = 0;
-    uint16_t matchSize = 0;
-    std::string matchSeq;
+// Direct-address table over 2-bit encoded k-mers, for pattern sets where every
+// pattern has the same length k (e.g. substitution-only edit variants).
+class KmerTable {
+    static constexpr uint8_t MATCH = builtinMotifs::MATCH;
+    static constexpr uint8_t FORWARD = builtinMotifs::FORWARD;
+    static constexpr uint8_t CANONICAL = builtinMotifs::CANONICAL;
+
+    std::vector<uint8_t> flags; // 4^k entries, 0 = not a pattern
+    const uint8_t* builtin = nullptr; // compile-time table used instead of flags
+    uint32_t mask = 0;
+    uint16_t kmerLen = 0;
+
+    static int8_t charToIndex(char c) {
+        switch (c) {
+            case 'A': return 0;
+            case 'C': return 1;
+            case 'G': return 2;
+            case 'T': return 3;
+            default:  return -1;
+        }
+    }
+
+public:
+    static constexpr uint16_t maxKmerLen = 10; // 1 MiB table
+
+    // false (and table left inactive) unless all patterns are ACGT-only and equally long
+    bool build(const std::vector<std::pair<std::string, bool>>& patternInfo,
+               const std::string& canonicalFwd, const std::string& canonicalRev) {
+        flags.clear();
+        builtin = nullptr;
+        kmerLen = 0;
+        if (patternInfo.empty()) return false;
+
+        size_t k = patternInfo.front().first.size();
+        if (k == 0 || k > maxKmerLen) return false;
+        for (const auto& [pattern, isForward] : patternInfo) {
+            if (pattern.size() != k) return false;
+            for (char c : pattern) {
+                if (charToIndex(c) < 0) return false;
+            }
+        }
+
+        kmerLen = static_cast<uint16_t>(k);
+        mask = (1u << (2 * kmerLen)) - 1;
+        builtin = builtinMotifs::find(patternInfo, canonicalFwd, canonicalRev);
+        if (builtin) return true;
+
+        flags.assign(static_cast<size_t>(mask) + 1, 0);
+        for (const auto& [pattern, isForward] : patternInfo) {
+            uint32_t code = 0;
+            for (char c : pattern) code = (code << 2) | static_cast<uint32_t>(charToIndex(c));
+            bool isCanonical = (pattern == canonicalFwd || pattern == canonicalRev);
+            flags[code] = MATCH | (isForward ? FORWARD : 0) | (isCanonical ? CANONICAL : 0);
+        }
+        return true;
+    }
+
+    bool isActive() const { return kmerLen != 0; }
+
+    // Same contract as Trie::scan: one table load per base, reset on non-ACGT.
+    // The built-in motif lengths get their own instantiation with k constant.
+    template <typename OnMatch>
+    void scan(const char* seq, uint64_t begin, uint64_t end, OnMatch&& onMatch) const {
+        switch (kmerLen) {
+            case 6: scanFixed<6>(seq, begin, end, onMatch); break;
+            case 7: scanFixed<7>(seq, begin, end, onMatch); break;
+            default: scanFixed<0>(seq, begin, end, onMatch); break;
+        }
+    }
+
+private:
+    template <uint16_t K, typename OnMatch>
+    void scanFixed(const char* seq, uint64_t begin, uint64_t end, OnMatch& onMatch) const {
+        const uint16_t k = K ? K : kmerLen;
+        const uint32_t codeMask = K ? (1u << (2 * K)) - 1 : mask;
+        const uint8_t* table = builtin ? builtin : flags.data();
+        const auto nextBase = kernels::active().nextBase;
+        uint32_t code = 0;
+        uint16_t filled = 0;
+        for (uint64_t j = begin; j < end; ++j) {
+            const uint8_t symbol = kernels::baseSymbols[static_cast<uint8_t>(seq[j])];
+            if (symbol > 3) {
+                filled = 0;
+                j = nextBase(seq, j + 1, end) - 1;
+                continue;
+            }
+            code = ((code << 2) | symbol) & codeMask;
+            if (filled < k && ++filled < k) continue;
+
+            uint8_t f = table[code];
+            if (f) {
+                onMatch(j + 1 - k, k, (f & FORWARD) != 0, (f & CANONICAL) != 0);
+            }
+        }
+    }
 };
 
+
 struct GapInfo {
     uint64_t start = 0;
     uint32_t length = 0;
@@ -136,15 +422,42 @@ struct WindowData {
     WindowData() : windowStart(0), currentWindowSize(0), gcContent(0.0f), shannonEntropy(0.0f) {}
 };
 
+// Compact window record, written once the window is scanned. Only the
+// five bedGraph values are kept, and starts are stored as the distance from
+// the previous window of the path, which is the step inside a segment and
+// the gap plus the segment tail across one. A record of size 0 only moves the
+// start, for distances past UINT32_MAX. Metrics not requested stay 0.
+struct WindowRecord {
+    uint32_t startDelta = 0;
+    uint32_t size = 0;
+    float density = 0.0f;
+    float canonicalRatio = 0.0f; // -1 when the window has no matches
+    float strandRatio = 0.0f;    // -1 when the window has no matches
+    float gcContent = 0.0f;
+    float shannonEntropy = 0.0f;
+};
+
+// bedGraph tracks of one window resolution; the buffers outlive the streams
+struct WindowTracks {
+    std::vector<char> densityBuf, canonicalRatioBuf, strandRatioBuf, gcBuf, entropyBuf;
+    std::ofstream density, canonicalRatio, strandRatio, gc, entropy;
+};
+
 struct SegmentData {
-    std::vector<WindowData> windows;
+    std::vector<std::vector<WindowRecord>> windows; // [level]: -w/-s, then --window-levels; first startDelta is from the segment start
     std::vector<TelomereBlock> terminalBlocks;
     std::vector<TelomereBlock> interstitialBlocks;
-    std::vector<MatchInfo> canonicalMatches;
-    std::vector<MatchInfo> nonCanonicalMatches;
-    std::vector<MatchInfo> fwdMatches;
-    std::vector<MatchInfo> revMatches;
-    std::vector<MatchInfo> allMatches;
+    MatchStore matches; // -m output; in tip scans every match, fed to the block builder at the end
+    uint64_t canonicalCount = 0;
+
+    // empties every buffer, keeping its capacity for the next segment
+    void clear() {
+        for (auto& level : windows) level.clear();
+        terminalBlocks.clear();
+        interstitialBlocks.clear();
+        matches.clear();
+        canonicalCount = 0;
+    }
 };
 
 
@@ -153,11 +466,12 @@ struct PathData {
     std::string header;
     std::vector<GapInfo> gapInfos;
     uint64_t pathSize;
-    std::vector<WindowData> windows;
+    std::vector<std::vector<SpillFile::Extent>> windows; // [level], read back from the spill when written
     std::vector<TelomereBlock> terminalBlocks;
     std::vector<TelomereBlock> interstitialBlocks;
-    std::vector<MatchInfo> canonicalMatches;
-    std::vector<MatchInfo> nonCanonicalMatches;
+    MatchStore matches; // canonical and terminal non-canonical matches, the -m output
+    std::vector<SpillFile::Extent> spilledMatches; // earlier matches, spilled under --max-memory
+    uint64_t canonicalCount = 0;
     std::string terminalLabel;
     ScaffoldType scaffoldType = ScaffoldType::NONE;
 };
@@ -165,8 +479,21 @@ struct PathData {
 
 class Teloscope {
     Trie trie; // Declare trie instance
+    KmerTable kmerTable; // fixed-length pattern sets bypass the automaton
+    MotifPrefilter prefilter; // skips anchor-free stretches when the pattern set allows it
+    PeriodicityFilter periodicity; // --periodic-scan: only tandem stretches of the canonical period
+    ApproxMatcher approxMatcher; // searches the seeds directly for indels, IUPAC classes and large variant sets
+    static constexpr uint64_t windowChunkBases = 4 << 20; // full scans split longer segments across idle workers
     UserInputTeloscope userInput; // Declare user input instance
-    std::vector<PathData> allPathData; // Assembly data
+    std::vector<PathData> allPathData; // Assembly data, one slot per path in input order
+    std::vector<Log> pathLogs; // walkPath logs, in the same slots
+    SpillFile spill; // window metrics of walked paths, and matches over the budget
+    MemoryBudget memoryBudget; // --max-memory, path results held until the report
+
+    // path components by uId, built once by the first walkPath
+    std::once_flag componentIndexOnce;
+    std::unordered_map<unsigned int, InSegment*> segmentIndex;
+    std::unordered_map<unsigned int, InGap*> gapIndex;
     
     // Assembly Summary
     uint32_t totalPaths = 0;
@@ -196,7 +523,34 @@ class Teloscope {
     uint32_t totalDiscordant = 0;
     uint32_t totalGappedDiscordant = 0;
 
+    // p * log2(p) for every base count of a full window, so -e needs no log2
+    // per window. Tail windows of other sizes fall back to computing it.
+    struct EntropyTable {
+        uint32_t windowSize = 0;
+        std::vector<float> terms;
+    };
+    static constexpr uint32_t maxEntropyTableSize = 1 << 20;
+    std::vector<EntropyTable> entropyTables; // -w and each --window-levels size
+
+    void buildEntropyTable(uint32_t windowSize) {
+        if (windowSize > maxEntropyTableSize) return;
+        EntropyTable& table = entropyTables.emplace_back();
+        table.windowSize = windowSize;
+        table.terms.assign(windowSize + 1, 0.0f);
+        for (uint32_t count = 1; count <= windowSize; ++count) {
+            float probability = static_cast<float>(count) / windowSize;
+            table.terms[count] = probability * std::log2(probability);
+        }
+    }
+
     inline float getShannonEntropy(const uint32_t nucleotideCounts[4], uint32_t windowSize) {
+        for (const EntropyTable& table : entropyTables) {
+            if (table.windowSize != windowSize) continue;
+            float entropy = 0.0;
+            for (int i = 0; i < 4; ++i) entropy -= table.terms[nucleotideCounts[i]];
+            return std::round(entropy * 1000.0f) / 1000.0f; // Round to 3 decimal places
+        }
+
         float entropy = 0.0;
         for (int i = 0; i < 4; ++i) {
             if (nucleotideCounts[i] > 0) {
@@ -236,13 +590,143 @@ class Teloscope {
 
     void computeSummaryCounts();
 
+    // Block detection fed one match at a time, in start order, while a segment
+    // is scanned. Terminal sub-blocks and interstitial blocks close as soon as
+    // a gap exceeds -k, so matches are held only where a boundary is still
+    // open: up to the end of the p telomere, and from the q terminal zone on,
+    // where the q telomere may still cut an interstitial block. Results equal
+    // a batch pass over all matches of the segment. One builder per worker
+    // thread is reset for each segment, so its buffers keep their capacity.
+    class BlockBuilder {
+        struct Chain { // matches joined by gaps of at most -k
+            uint64_t start = 0, end = 0, prevPosition = 0;
+            uint32_t counts = 0, forwardCount = 0, canonicalCount = 0;
+            uint32_t totalCovered = 0, fwdCovered = 0, canCovered = 0;
+            bool open = false;
+
+            void begin(const MatchInfo& m);
+            void extend(const MatchInfo& m);
+            bool accepts(const MatchInfo& m, uint16_t maxGap) const;
+            TelomereBlock toBlock() const;
+        };
+
+        static constexpr uint16_t minInterstitialCanonical = 4;
+
+        uint64_t segmentSize = 0, absPos = 0;
+        bool interstitial = false;
+        uint32_t terminalLimit = 0;
+        uint16_t matchDist = 0, blockDist = 0, minBlockCounts = 0, minBlockLen = 0;
+        float minBlockDensity = 0;
+        uint16_t minInterstitialLen = 0;
+
+        uint64_t fwdBoundary = 0, revBoundary = 0;
+        uint64_t qZoneStart = 0;
+
+        Chain fwdChain, revChain, itsChain;
+        std::vector<TelomereBlock> pSubBlocks, qSubBlocks;
+        std::vector<TelomereBlock> terminalBlocks, interstitialBlocks;
+        bool pDone = false;
+        MatchStore head;    // matches until the p telomere is known
+        MatchStore pending; // open interstitial chain, then everything once deferred
+        bool deferred = false;
+
+        bool inPZone(uint64_t position) const;
+        void closeSubBlock(const Chain& chain, std::vector<TelomereBlock>& subBlocks) const;
+        void closeInterstitial(const Chain& chain);
+        uint64_t mergeSubBlocks(const std::vector<TelomereBlock>& subBlocks, bool fromStart);
+        void finishP();
+        void addInterstitial(const MatchInfo& m);
+
+    public:
+        // starts a new segment, dropping any state of the previous one
+        void reset(const UserInputTeloscope& userInput, uint64_t segmentSize, uint64_t absPos, bool interstitial);
+
+        void add(const MatchInfo& m);
+
+        // appends terminal blocks p first, then q from the end inward; interstitial blocks in order
+        void finish(std::vector<TelomereBlock>& outTerminal, std::vector<TelomereBlock>& outInterstitial);
+    };
+
+    void reportAutomatonLayout() const; // verbose only
+
+    uint16_t getLongestMatchSize() const {
+        return approxMatcher.isActive() ? approxMatcher.getLongestMatchSize() : trie.getLongestPatternSize();
+    }
+
+    // onMatch(start, length, isForward, isCanonical, distance); the distance is
+    // the edit count of a bit-parallel hit and 0 for the exact engines
+    template <typename OnMatch>
+    void scanMotifs(const char* seq, uint64_t begin, uint64_t end, OnMatch&& onMatch) const {
+        auto exactMatch = [&](uint64_t start, uint16_t length, bool isForward, bool isCanonical) {
+            onMatch(start, length, isForward, isCanonical, uint8_t(0));
+        };
+        auto exactScan = [&](uint64_t from, uint64_t to) {
+            if (approxMatcher.isActive()) {
+                approxMatcher.scan(seq, from, to, onMatch);
+            } else if (kmerTable.isActive()) {
+                kmerTable.scan(seq, from, to, exactMatch);
+            } else {
+                trie.scan(seq, from, to, exactMatch);
+            }
+        };
+
+        // short ranges are cheaper to scan directly than to search for anchors
+        auto anchoredScan = [&](uint64_t from, uint64_t to) {
+            if (prefilter.isActive() && to - from >= 256) {
+                prefilter.forEachCandidateSpan(seq, from, to, exactScan);
+            } else {
+                exactScan(from, to);
+            }
+        };
+
+        if (periodicity.isActive() && end - begin >= 256) {
+            periodicity.forEachCandidateSpan(seq, begin, end, anchoredScan);
+        } else {
+            anchoredScan(begin, end);
+        }
+    }
+
 public:
 
-    Teloscope(UserInputTeloscope userInput) : userInput(userInput) {
-        for (const auto& [pattern, isForward] : this->userInput.patternInfo) {
-            bool isCanonical = (pattern == this->userInput.canonicalFwd ||
-                                pattern == this->userInput.canonicalRev);
-            trie.insertPattern(pattern, isForward, isCanonical);
+    Teloscope(UserInputTeloscope userInput)
+        : userInput(userInput),
+          spill(userInput.outRoute + "/" + userInput.inSequenceName + ".spill.tmp") {
+        memoryBudget.setLimit(static_cast<uint64_t>(this->userInput.maxMem * 1e9));
+        const auto& patternInfo = this->userInput.patternInfo;
+        const std::string& canonicalFwd = this->userInput.canonicalFwd;
+        const std::string& canonicalRev = this->userInput.canonicalRev;
+
+        // indels cannot be enumerated as variants, and main() leaves IUPAC sets
+        // and sets cheaper to search from their seeds unenumerated (see
+        // ApproxMatcher::cheaperThanAutomaton); main() rejects seeds that do not fit
+        if (patternInfo.empty() || this->userInput.indels) {
+            bool built = approxMatcher.build(getSeedsWithOrientation(this->userInput.rawPatterns, canonicalFwd),
+                                             this->userInput.editDistance, this->userInput.indels,
+                                             canonicalFwd, canonicalRev);
+            if (!built) {
+                throw std::runtime_error("patterns do not fit the bit-parallel matcher");
+            }
+        } else {
+            kmerTable.build(patternInfo, canonicalFwd, canonicalRev);
+        }
+
+        if (!approxMatcher.isActive()) {
+            for (const auto& [pattern, isForward] : patternInfo) {
+                bool isCanonical = (pattern == canonicalFwd || pattern == canonicalRev);
+                trie.insertPattern(pattern, isForward, isCanonical);
+            }
+            trie.buildAutomaton();
+            if (!kmerTable.isActive()) reportAutomatonLayout();
+        }
+        if (!this->userInput.indels) {
+            prefilter.build(patternInfo); // anchors come from the variants, so substitutions only
+        }
+        if (this->userInput.periodicScan) {
+            periodicity.build(this->userInput.canonicalSize, getLongestMatchSize());
+        }
+        if (this->userInput.outEntropy) {
+            buildEntropyTable(this->userInput.windowSize);
+            for (uint32_t level : this->userInput.windowLevels) buildEntropyTable(level);
         }
     }
 
@@ -251,29 +735,49 @@ public:
     bool walkSegmentForPath(InSegment* segment, InSequences& inSequences,
                             char pathOrient, bool isFirst);
 
-    bool walkPath(InPath* path, std::vector<InSegment*> &inSegments, std::vector<InGap> &inGaps);
+    // sizes the result slots; each walkPath fills its own without locking
+    void reservePathSlots(size_t count) {
+        allPathData.assign(count, PathData());
+        pathLogs.assign(count, Log());
+    }
+
+    bool walkPath(InPath* path, size_t slot, std::vector<InSegment*> &inSegments, std::vector<InGap> &inGaps);
+
+    void printPathLogs(); // verbose only, in input order
 
     void analyzeWindow(const std::string_view &window, uint64_t windowStart,
                         WindowData& windowData, WindowData& nextOverlapData,
-                        SegmentData& segmentData, uint64_t segmentSize, uint64_t absPos);
+                        SegmentData& segmentData, BlockBuilder& blocks,
+                        uint64_t segmentSize, uint64_t absPos);
 
-    SegmentData scanSegment(std::string &sequence, uint64_t absPos, bool tipsOnly);
+    // the reported metrics of a window, from its match coverage and base counts
+    WindowRecord makeWindowRecord(uint32_t windowSize, uint32_t totalCovered, uint32_t fwdCovered,
+                                  uint32_t canonicalCovered, const uint32_t nucleotideCounts[4]);
 
-    inline void sortBySeqPos() {
-        std::sort(allPathData.begin(), allPathData.end(), [](const PathData& one, const PathData& two) {
-            return one.seqPos < two.seqPos;
-        });
+    // -w/-s, then each --window-levels size
+    size_t windowLevelCount() const { return 1 + userInput.windowLevels.size(); }
+
+    uint64_t windowLevelStep(size_t level) const {
+        return level == 0 ? userInput.step : userInput.windowLevels[level - 1];
     }
 
-    uint64_t getTerminalBlocks(
-        const std::vector<MatchInfo>& matches,
-        std::vector<TelomereBlock>& outBlocks,
-        uint64_t segmentSize, uint64_t absPos, bool fromStart);
+    // full scan of windows [firstWindow, lastWindow) of a segment in one pass,
+    // every window from prefix sums at its start and end. The matches starting
+    // in the range go to blocks, or all of them to segmentData.matches when
+    // blocks is null.
+    void scanWindowsOnePass(std::string_view sequence, uint64_t absPos,
+                            uint64_t firstWindow, uint64_t lastWindow,
+                            SegmentData& segmentData, BlockBuilder* blocks);
+
+    // full scan of a segment; long ones are cut into window ranges that the
+    // calling thread and idle workers scan concurrently, joined in order as
+    // they finish with at most two per thread scanned ahead of the join
+    void scanWindowChunks(std::string_view sequence, uint64_t absPos,
+                          SegmentData& segmentData, BlockBuilder& blocks);
 
-    void getInterstitialBlocks(
-        const std::vector<MatchInfo>& allMatches,
-        std::vector<TelomereBlock>& outBlocks,
-        uint64_t fwdBoundary, uint64_t revBoundary);
+    // fills segmentData, which is cleared first; callers keep one per worker
+    // thread so windows, blocks and matches reuse their storage across segments
+    void scanSegment(std::string_view sequence, uint64_t absPos, bool tipsOnly, SegmentData& segmentData);
 
     void labelTerminalBlocks(std::vector<TelomereBlock>& blocks, uint16_t gaps,
                         std::string& terminalLabel, ScaffoldType& scaffoldType,
@@ -281,11 +785,7 @@ public:
     
     std::string getChrType(const std::string& labels, uint16_t gaps);
     
-    void writeBEDFile(std::ofstream& windowDensityFile,
-                    std::ofstream& windowCanonicalRatioFile,
-                    std::ofstream& windowStrandRatioFile,
-                    std::ofstream& windowGCFile,
-                    std::ofstream& windowEntropyFile,
+    void writeBEDFile(std::vector<WindowTracks>& windowTracks, // [level]
                     std::ofstream& canonicalMatchFile,
                     std::ofstream& noncanonicalMatchFile,
                     std::ofstream& terminalBlocksFile,
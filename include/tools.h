@@ -46,4 +46,39 @@ std::vector<std::pair<std::string, bool>> expandPatternsWithOrientation(
     uint8_t editDistance,
     const std::string &canonicalFwd);
 
+bool isCloserToFwd(const std::string &pattern, const std::string &canonicalFwd);
+
+// reverse complement that maps IUPAC codes to their complement classes
+std::string revComClasses(const std::string &seed);
+
+// literal combinations of an IUPAC seed checked for orientation
+constexpr uint64_t maxOrientationChecks = 4096;
+
+// literal combinations of an IUPAC seed, capped at maxOrientationChecks + 1; 0 if not IUPAC
+uint64_t countSeedCombinations(const std::string &seed);
+
+// Seeds and their reverse complements with IUPAC codes kept as character
+// classes, no edit variants. A seed whose combinations differ in orientation
+// is split into its literal combinations. A seed with more combinations than
+// can be checked is kept whole and its hits are oriented one by one by the
+// matcher (see ApproxMatcher), so its orientation here is only a default.
+std::vector<std::pair<std::string, bool>> getSeedsWithOrientation(
+    const std::vector<std::string> &rawPatterns,
+    const std::string &canonicalFwd);
+
+// upper bound on the expandPatternsWithOrientation() size, without expanding
+uint64_t countPatternVariants(
+    const std::vector<std::string> &rawPatterns,
+    uint8_t editDistance);
+
+// states of an automaton over the expandPatternsWithOrientation() variants:
+// the distinct prefixes of each seed's variants, both strands, no sharing
+// between seeds
+uint64_t countAutomatonStates(
+    const std::vector<std::string> &rawPatterns,
+    uint8_t editDistance);
+
+// true if any seed has an IUPAC code other than A, C, G or T
+bool hasDegenerateSeeds(const std::vector<std::string> &rawPatterns);
+
 #endif // TOOLS_H
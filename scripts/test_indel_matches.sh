@@ -0,0 +1,79 @@
+#!/bin/bash
+# Test bit-parallel --indels matches: verifies the -m BEDs (start, end, bases,
+# edit distance, strand) against expected files for planted indels.
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+REPO_DIR="$(cd "$SCRIPT_DIR/.." && pwd)"
+TELO="$REPO_DIR/build/bin/teloscope"
+TMP_DIR="$REPO_DIR/testFiles/tmp_indels"
+EXPECTED_DIR="$REPO_DIR/testFiles/expected"
+
+PASS=0
+FAIL=0
+TOTAL=0
+
+red()   { printf "\033[0;31m%s\033[0m" "$1"; }
+green() { printf "\033[0;32m%s\033[0m" "$1"; }
+
+run_test() {
+    local fa_file="$1"       # e.g. indel_test.fa
+    local opts="$2"          # e.g. "--indels -x 1"
+    local suffix="$3"        # e.g. _noncanonical_matches.bed
+    local desc="$4"
+    TOTAL=$((TOTAL + 1))
+
+    rm -rf "$TMP_DIR"
+    mkdir -p "$TMP_DIR"
+
+    # shellcheck disable=SC2086
+    "$TELO" -f "$REPO_DIR/testFiles/$fa_file" -o "$TMP_DIR" -m $opts >/dev/null 2>&1 || true
+
+    local out_file
+    out_file=$(find "$TMP_DIR" -name "*$suffix" 2>/dev/null | head -1)
+
+    if [ -z "$out_file" ]; then
+        FAIL=$((FAIL + 1))
+        echo "  $(red FAIL) $desc — *$suffix not found"
+        return
+    fi
+
+    local expected="$EXPECTED_DIR/$fa_file$suffix"
+    if diff <(sed '/^$/d' "$out_file") <(sed '/^$/d' "$expected") >/dev/null 2>&1; then
+        PASS=$((PASS + 1))
+        echo "  $(green PASS) $desc"
+    else
+        FAIL=$((FAIL + 1))
+        echo "  $(red FAIL) $desc — content mismatch:"
+        diff <(sed '/^$/d' "$out_file") <(sed '/^$/d' "$expected") || true
+    fi
+}
+
+# Check binary exists
+if [ ! -x "$TELO" ]; then
+    echo "Error: teloscope binary not found at $TELO"
+    echo "Run 'make' first."
+    exit 1
+fi
+
+echo "Running --indels match tests..."
+echo ""
+
+# indel_test.fa plants, at -x 1:
+#   78-85   TTAGCGG  1-bp insertion in a TTAGGG array
+#   181-186 CCCAA    1-bp deletion in a CCCTAA array
+#   276-281 TTAGG    truncated repeat ending at an N-run (281-291)
+#   291-296 TAGGG    truncated repeat starting right after it
+echo "Planted indels (--indels -x 1):"
+run_test "indel_test.fa" "--indels -x 1" "_noncanonical_matches.bed" "insertion, deletion and N-run edges"
+run_test "indel_test.fa" "--indels -x 1" "_canonical_matches.bed"    "exact repeats around them"
+
+echo ""
+echo "Results: $PASS passed, $FAIL failed (out of $TOTAL)"
+
+rm -rf "$TMP_DIR"
+
+if [ "$FAIL" -gt 0 ]; then
+    exit 1
+fi
+exit 0
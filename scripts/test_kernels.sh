@@ -0,0 +1,11 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT=$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)
+BUILD_DIR=${BUILD_DIR:-"$ROOT/build/bin"}
+OUTPUT=$(mktemp "${TMPDIR:-/tmp}/teloscope_kernels.XXXXXX")
+trap 'rm -f "$OUTPUT"' EXIT
+
+"${CXX:-g++}" -std=gnu++17 -O2 -I"$ROOT/include" \
+    "$ROOT/tests/test_kernels.cpp" "$BUILD_DIR/.o/kernels" -o "$OUTPUT"
+"$OUTPUT"
@@ -0,0 +1,11 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT=$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)
+BUILD_DIR=${BUILD_DIR:-"$ROOT/build/bin"}
+OUTPUT=$(mktemp "${TMPDIR:-/tmp}/teloscope_match_store.XXXXXX")
+trap 'rm -f "$OUTPUT"' EXIT
+
+"${CXX:-g++}" -std=gnu++17 -O2 -pthread -I"$ROOT/include" \
+    "$ROOT/tests/test_match_store.cpp" "$BUILD_DIR/.o/match-store" "$BUILD_DIR/.o/spill-file" -o "$OUTPUT"
+"$OUTPUT"
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""Known-answer test for the motif scan: runs teloscope -m on generated
+sequences (mixed case, N runs, planted and mutated repeats) and compares
+both match BEDs with a brute-force search for every pattern variant."""
+
+import itertools
+import os
+import pathlib
+import random
+import subprocess
+import sys
+import tempfile
+
+
+ROOT = pathlib.Path(__file__).resolve().parents[1]
+DEFAULT_TELOSCOPE = ROOT / "build/bin" / ("teloscope.exe" if os.name == "nt" else "teloscope")
+TELOSCOPE = pathlib.Path(os.environ.get("TELOSCOPE", DEFAULT_TELOSCOPE))
+
+IUPAC = {
+    "A": "A", "C": "C", "G": "G", "T": "T",
+    "R": "AG", "Y": "CT", "M": "AC", "K": "GT", "S": "CG", "W": "AT",
+    "H": "ACT", "B": "CGT", "V": "ACG", "D": "AGT", "N": "ACGT",
+}
+COMPLEMENT = {
+    "A": "T", "C": "G", "G": "C", "T": "A",
+    "R": "Y", "Y": "R", "M": "K", "K": "M", "S": "S", "W": "W",
+    "H": "D", "B": "V", "V": "B", "D": "H", "N": "N",
+}
+CANONICAL_FWD = "CCCTAA"
+CANONICAL_REV = "TTAGGG"
+WINDOW = "4000"  # longer than every record, so no match crosses a window
+
+
+def require(condition, message):
+    if not condition:
+        raise AssertionError(message)
+
+
+def reverse_complement(pattern):
+    return "".join(COMPLEMENT[c] for c in reversed(pattern))
+
+
+def make_records():
+    rng = random.Random(11)
+    motifs = ["TTAGGG", "CCCTAA", "TTTAGGG", "CCCTAAA", "TTGGGG"]
+
+    def mutate(motif):
+        bases = list(motif)
+        for _ in range(rng.choice((0, 0, 1, 1, 2))):
+            bases[rng.randrange(len(bases))] = rng.choice("ACGT")
+        return "".join(bases)
+
+    def record(length):
+        parts = []
+        while sum(map(len, parts)) < length:
+            pick = rng.random()
+            if pick < 0.5:
+                parts.append(mutate(rng.choice(motifs)))
+            elif pick < 0.6:
+                parts.append("N" * rng.randint(1, 12))
+            else:
+                parts.append("".join(rng.choice("ACGT") for _ in range(rng.randint(1, 8))))
+        seq = "".join(parts)[:length]
+        return "".join(c.lower() if rng.random() < 0.3 else c for c in seq)
+
+    lengths = list(range(1, 131)) + [1000, 2500]
+    return [(f"seq{length}", record(length)) for length in lengths]
+
+
+def expected_matches(records, patterns, edit_distance):
+    """(header, start, end, bases) -> lowest substitution count, for every
+    window of a pattern's length with only ACGT bases."""
+    seeds = set(patterns) | {reverse_complement(p) for p in patterns}
+    lengths = sorted({len(seed) for seed in seeds})
+    matches = {}
+    for header, seq in records:
+        upper = seq.upper()
+        for start, length in itertools.product(range(len(upper)), lengths):
+            bases = upper[start:start + length]
+            if len(bases) < length or any(c not in "ACGT" for c in bases):
+                continue
+            distance = min(
+                sum(c not in IUPAC[s] for c, s in zip(bases, seed))
+                for seed in seeds if len(seed) == length
+            )
+            if distance <= edit_distance:
+                matches[(header, start, start + length, bases)] = distance
+    return matches
+
+
+def read_bed(path):
+    rows = {}
+    for line in path.read_text().splitlines():
+        if not line:
+            continue
+        fields = line.split("\t")
+        key = (fields[0], int(fields[1]), int(fields[2]), fields[3])
+        require(key not in rows, f"{path.name}: duplicate match {key}")
+        rows[key] = int(fields[4]) if len(fields) > 4 else None
+    return rows
+
+
+def check_case(tmp, fasta, records, patterns, edit_distance, options, with_distance):
+    out_dir = tmp / ("out_" + "_".join(patterns) + f"_x{edit_distance}" + "".join(options))
+    out_dir.mkdir()
+    args = [str(TELOSCOPE), "-f", str(fasta), "-o", str(out_dir), "-m", "-x", str(edit_distance),
+            "-w", WINDOW, "-s", WINDOW, "-p", ",".join(patterns), *options]
+    result = subprocess.run(args, stdout=subprocess.PIPE, stderr=subprocess.PIPE, check=False, timeout=120)
+    require(result.returncode == 0,
+            f"{' '.join(args)} failed with exit {result.returncode}:\n{result.stderr.decode(errors='replace')}")
+
+    expected = expected_matches(records, patterns, edit_distance)
+    canonical = {key: d for key, d in expected.items() if key[3] in (CANONICAL_FWD, CANONICAL_REV)}
+    noncanonical = {key: d for key, d in expected.items() if key not in canonical}
+
+    for suffix, wanted in (("_canonical_matches.bed", canonical), ("_noncanonical_matches.bed", noncanonical)):
+        found_files = [p for p in out_dir.iterdir() if p.name.endswith(suffix) and
+                       not (suffix == "_canonical_matches.bed" and p.name.endswith("_noncanonical_matches.bed"))]
+        require(len(found_files) == 1, f"{suffix} not written for {' '.join(args)}")
+        found = read_bed(found_files[0])
+        missing = sorted(set(wanted) - set(found))
+        extra = sorted(set(found) - set(wanted))
+        require(not missing and not extra,
+                f"{' '.join(args)}: {suffix} has {len(missing)} missing and {len(extra)} extra matches, "
+                f"first missing {missing[:3]}, first extra {extra[:3]}")
+        if with_distance:
+            wrong = [(key, found[key], d) for key, d in wanted.items() if found[key] != d]
+            require(not wrong, f"{' '.join(args)}: {suffix} edit distances differ, first {wrong[:3]}")
+
+
+def main():
+    require(TELOSCOPE.exists(), f"Teloscope binary not found: {TELOSCOPE}")
+    records = make_records()
+    cases = (
+        # patterns, -x, extra options, bit-parallel matcher (distance column)
+        (["TTAGGG", "CCCTAA"], 0, [], False),                # built-in k-mer table
+        (["TTAGGG", "CCCTAA"], 2, [], False),
+        (["TTAGGG", "TTTAGGG", "TTGGGG"], 0, [], False),     # mixed lengths: automaton and anchors
+        (["TTAGGG", "TTTAGGG", "TTGGGG"], 1, [], False),
+        (["TTAGGG", "TTTAGGG", "TTGGGG"], 1, ["--kernel", "scalar"], False),
+        (["TTRGGG", "TTTAGGG"], 1, [], True),                 # IUPAC classes: bit-parallel matcher
+    )
+    with tempfile.TemporaryDirectory(prefix="teloscope_motif_matches_") as temp:
+        tmp = pathlib.Path(temp)
+        fasta = tmp / "motifs.fa"
+        fasta.write_text("".join(f">{header}\n{seq}\n" for header, seq in records))
+        for patterns, edit_distance, options, with_distance in cases:
+            check_case(tmp, fasta, records, patterns, edit_distance, options, with_distance)
+    print(f"PASS motif matches ({len(cases)} pattern sets, {len(records)} sequences)")
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except Exception as error:
+        print(f"FAIL motif matches: {error}", file=sys.stderr)
+        raise
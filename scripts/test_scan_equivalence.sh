@@ -0,0 +1,197 @@
+#!/bin/bash
+# Scan equivalence tests: runs teloscope twice on the same input, once with
+# baseline options and once with a variant that must not change the output
+# (adaptive tips, scan engines, kernels, memory limits, threads), and diffs
+# the output files the baseline run writes. No expected files needed.
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+REPO_DIR="$(cd "$SCRIPT_DIR/.." && pwd)"
+TELO="$REPO_DIR/build/bin/teloscope"
+TMP_DIR="$REPO_DIR/testFiles/tmp_equivalence"
+GEN_DIR="$REPO_DIR/testFiles/tmp_equivalence_inputs"
+
+PASS=0
+FAIL=0
+TOTAL=0
+
+red()   { printf "\033[0;31m%s\033[0m" "$1"; }
+green() { printf "\033[0;32m%s\033[0m" "$1"; }
+
+run_pair() {
+    local fa_file="$1"       # e.g. boundary_adaptive_chain.fa
+    local base_opts="$2"     # options of the reference run
+    local variant_opts="$3"  # options that must give the same files
+    local desc="$4"
+    local compared="${5:-*}" # output files to compare, e.g. "*_canonical_matches.bed"
+    local match_fields="${6:-}" # columns of the match BEDs to compare, e.g. "1-4"
+    TOTAL=$((TOTAL + 1))
+
+    rm -rf "$TMP_DIR"
+    mkdir -p "$TMP_DIR/base" "$TMP_DIR/variant"
+
+    # shellcheck disable=SC2086
+    "$TELO" -f "$fa_file" -o "$TMP_DIR/base" $base_opts >/dev/null 2>&1 || true
+    # shellcheck disable=SC2086
+    "$TELO" -f "$fa_file" -o "$TMP_DIR/variant" $base_opts $variant_opts >/dev/null 2>&1 || true
+
+    local files
+    files=$(cd "$TMP_DIR/base" && find . -type f -name "$compared" \
+        \( -name "*.bed" -o -name "*.tsv" -o -name "*.bedgraph" \) | sort)
+    if [ -z "$files" ]; then
+        FAIL=$((FAIL + 1))
+        echo "  $(red FAIL) $desc — baseline run wrote no output"
+        return
+    fi
+
+    local f
+    for f in $files; do
+        if [ -n "$match_fields" ] && [[ "$f" == *_matches.bed ]]; then
+            cut -f"$match_fields" "$TMP_DIR/base/$f" > "$TMP_DIR/base.cut"
+            cut -f"$match_fields" "$TMP_DIR/variant/$f" > "$TMP_DIR/variant.cut"
+        else
+            cp "$TMP_DIR/base/$f" "$TMP_DIR/base.cut"
+            cp "$TMP_DIR/variant/$f" "$TMP_DIR/variant.cut"
+        fi
+        if ! diff "$TMP_DIR/base.cut" "$TMP_DIR/variant.cut" >/dev/null 2>&1; then
+            FAIL=$((FAIL + 1))
+            echo "  $(red FAIL) $desc — ${f#./} differs:"
+            diff "$TMP_DIR/base.cut" "$TMP_DIR/variant.cut" | head -20 || true
+            return
+        fi
+    done
+
+    PASS=$((PASS + 1))
+    echo "  $(green PASS) $desc"
+}
+
+# ~9 Mbp sequence with telomeric arrays across the chunk bounds of the
+# full scan (4194 kbp at -s 1000, 4100 kbp at -s 500 with 100 kbp levels)
+make_long_fasta() {
+    python3 - "$1" <<'PYEOF'
+import random, sys
+random.seed(7)
+def filler(n):
+    return "".join(random.choices("ACGT", k=n))
+parts, pos = [], 0
+def put(s):
+    global pos
+    parts.append(s)
+    pos += len(s)
+put("CCCTAA" * 1000)
+for at, motif in ((4099700, "TTAGGG"), (4193700, "CCCTAA"), (8199700, "TTAGGG"), (8387700, "TTAGGG")):
+    put(filler(at - pos))
+    put(motif * 100)
+put(filler(200000))
+put("N" * 5000)
+put(filler(9000000 - pos))
+put("TTAGGG" * 1000)
+seq = "".join(parts)
+with open(sys.argv[1], "w") as out:
+    out.write(">chr_long\n")
+    for i in range(0, len(seq), 80):
+        out.write(seq[i:i + 80] + "\n")
+PYEOF
+}
+
+# fragmented assembly: 3000 records from 1 bp to 20 kbp, many with
+# telomeric ends and gaps, so paths finish out of input order
+make_fragmented_fasta() {
+    python3 - "$1" <<'PYEOF'
+import random, sys
+random.seed(11)
+with open(sys.argv[1], "w") as out:
+    for r in range(3000):
+        n = random.choice((1, 7, 50, 400, 3000, 20000)) + random.randrange(50)
+        seq = random.choices("ACGTacgt", k=n)
+        if n > 100 and random.random() < 0.5:
+            seq[:60] = "CCCTAA" * 10
+        if n > 100 and random.random() < 0.5:
+            seq[-60:] = "ttaggg" * 10
+        if n > 1000 and random.random() < 0.3:
+            at = random.randrange(n - 200)
+            seq[at:at + 100] = "N" * 100
+        out.write(">scaffold_%d\n%s\n" % (r, "".join(seq)))
+PYEOF
+}
+
+# Check binary exists
+if [ ! -x "$TELO" ]; then
+    echo "Error: teloscope binary not found at $TELO"
+    echo "Run 'make' first."
+    exit 1
+fi
+
+FILES="$REPO_DIR/testFiles"
+
+echo "Running scan equivalence tests..."
+echo ""
+
+echo "Adaptive tips (--adaptive-extent) vs full -t scan:"
+run_pair "$FILES/boundary_adaptive_chain.fa" "-t 3000" "--adaptive-extent 300"  "chain through non-canonical matches"
+run_pair "$FILES/boundary_adaptive_merge.fa" "-t 3000" "--adaptive-extent 300"  "second sub-block within -d"
+for fa in boundary_cross.fa boundary_extend_its.fa boundary_multiple_p.fa boundary_zone_shift.fa t2t.fa; do
+    run_pair "$FILES/$fa" "-t 1500" "--adaptive-extent 200" "${fa%.fa}"
+done
+
+echo ""
+echo "Streamed blocks: no match list (no -m) vs stored matches (-m):"
+for fa in boundary_cross.fa boundary_extend_its.fa boundary_fail_filter.fa boundary_its_at_edge.fa \
+          boundary_multiple_p.fa boundary_no_terminal.fa boundary_zone_shift.fa its.fa multi.fa; do
+    run_pair "$FILES/$fa" "-i" "-m" "${fa%.fa}"
+done
+
+echo ""
+echo "Window levels: blocks, -m matches and report with vs without --window-levels:"
+run_pair "$FILES/boundary_window_levels.fa" "-i -m" "--window-levels 2000,4000" "arrays across window bounds"
+run_pair "$FILES/its.fa" "-i -m -w 500 -s 500" "--window-levels 1000,5000" "its -w 500"
+
+echo ""
+echo "Kernels: --kernel scalar vs auto:"
+for fa in t2t.fa edit_test.fa gapped_t2t.fa multi_gap_t2t.fa its.fa; do
+    run_pair "$FILES/$fa" "-i -m -r -g -e" "--kernel scalar" "${fa%.fa}"
+done
+
+echo ""
+echo "Memory budget: --max-memory spill vs unbounded:"
+for fa in multi.fa multi_gap_t2t.fa its.fa; do
+    run_pair "$FILES/$fa" "-i -m -r -g -e" "--max-memory 0.000001" "${fa%.fa}"
+done
+
+echo ""
+echo "Bit-parallel --indels vs enumerated variants (canonical matches; all output at -x 0;"
+echo "match BEDs without the distance and strand columns of the bit-parallel matcher):"
+run_pair "$FILES/edit_test.fa" "-m -x 0" "--indels" "edit_test -x 0" "*" "1-4"
+run_pair "$FILES/edit_test.fa" "-m -x 1" "--indels" "edit_test -x 1" "*_canonical_matches.bed" "1-4"
+run_pair "$FILES/edit_test.fa" "-m -x 2" "--indels" "edit_test -x 2" "*_canonical_matches.bed" "1-4"
+
+echo ""
+echo "Full scan: chunked (-j 4) vs single pass (-j 1):"
+rm -rf "$GEN_DIR"
+mkdir -p "$GEN_DIR"
+make_long_fasta "$GEN_DIR/long.fa"
+run_pair "$GEN_DIR/long.fa" "-j 1 -i -m -r -g" "-j 4" "default windows"
+run_pair "$GEN_DIR/long.fa" "-j 1 -i -m -r -w 1000 -s 500 --window-levels 10000,100000" "-j 4" "overlapping windows and levels"
+run_pair "$GEN_DIR/long.fa" "-j 1 -i -m -x 2 --indels" "-j 4" "bit-parallel matcher"
+rm -rf "$GEN_DIR"
+
+echo ""
+echo "Path order: many records with -j 8 vs -j 1:"
+mkdir -p "$GEN_DIR"
+make_fragmented_fasta "$GEN_DIR/fragmented.fa"
+run_pair "$GEN_DIR/fragmented.fa" "-j 1 -i -m -r -g -e" "-j 8" "3000 records"
+run_pair "$GEN_DIR/fragmented.fa" "-j 1 -i -m --max-memory 0.000001" "-j 8" "3000 records, spilled matches"
+for fa in multi.fa multi_gap_t2t.fa its.fa; do
+    run_pair "$FILES/$fa" "-j 1 -i -m -r" "-j 8" "${fa%.fa}"
+done
+rm -rf "$GEN_DIR"
+
+echo ""
+echo "Results: $PASS passed, $FAIL failed (out of $TOTAL)"
+
+rm -rf "$TMP_DIR"
+
+if [ "$FAIL" -gt 0 ]; then
+    exit 1
+fi
+exit 0
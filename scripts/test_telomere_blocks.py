@@ -0,0 +1,285 @@
+#!/usr/bin/env python3
+"""Known-answer test for the streamed block builder: runs teloscope -i -n on
+generated records (p and q arrays split by gaps around -k and -d, interstitial
+arrays of either strand, mutated and soft-masked repeats) and compares the
+terminal and interstitial BEDs with a batch pass over a brute-force match
+list, the way blocks were built before they were streamed."""
+
+import os
+import pathlib
+import random
+import subprocess
+import sys
+import tempfile
+
+
+ROOT = pathlib.Path(__file__).resolve().parents[1]
+DEFAULT_TELOSCOPE = ROOT / "build/bin" / ("teloscope.exe" if os.name == "nt" else "teloscope")
+TELOSCOPE = pathlib.Path(os.environ.get("TELOSCOPE", DEFAULT_TELOSCOPE))
+
+CANONICAL_FWD = "CCCTAA"
+CANONICAL_REV = "TTAGGG"
+WINDOW = "100000"  # longer than every record, so every match reaches the blocks
+MIN_BLOCK_COUNTS = 2
+MIN_INTERSTITIAL_CANONICAL = 4
+
+
+def require(condition, message):
+    if not condition:
+        raise AssertionError(message)
+
+
+def make_records():
+    rng = random.Random(3)
+
+    def filler(n):
+        return "".join(rng.choice("ACGTAG") for _ in range(n))
+
+    def array(motif, copies):
+        units = []
+        for _ in range(copies):
+            unit = list(motif)
+            if rng.random() < 0.15:
+                unit[rng.randrange(6)] = rng.choice("ACGT")
+            units.append("".join(unit))
+        return "".join(units)
+
+    def arm(motif):
+        # sub-blocks split by gaps just under and over the -k and -d cut-offs
+        parts = []
+        for _ in range(rng.randint(1, 4)):
+            parts.append(array(motif, rng.randint(1, 80)))
+            parts.append(filler(rng.choice((10, 40, 45, 60, 300, 480, 520, 900))))
+        return "".join(parts)
+
+    records = {}
+    for r in range(60):
+        parts = []
+        if rng.random() < 0.7:
+            parts.append(arm(CANONICAL_FWD))
+        parts.append(filler(rng.randint(0, 4000)))
+        for _ in range(rng.randint(0, 3)):
+            parts.append(array(rng.choice((CANONICAL_FWD, CANONICAL_REV)), rng.randint(1, 30)))
+            if rng.random() < 0.3:
+                parts.append(array(CANONICAL_FWD if parts[-1][:3] == "TTA" else CANONICAL_REV, rng.randint(1, 5)))
+            parts.append(filler(rng.randint(20, 3000)))
+        if rng.random() < 0.7:
+            parts.append(arm(CANONICAL_REV))
+        if rng.random() < 0.1:  # arms on the wrong ends
+            parts.reverse()
+        seq = "".join(parts) or filler(100)
+        records[f"scaffold_{r}"] = "".join(c.lower() if rng.random() < 0.2 else c for c in seq)
+    return records
+
+
+def find_matches(seq, edit_distance):
+    """(position, size, isForward, isCanonical) in start order; forward
+    matches are closer to CCCTAA, the forward canonical pattern."""
+    upper = seq.upper()
+    matches = []
+    for start in range(len(upper) - 5):
+        bases = upper[start:start + 6]
+        if any(c not in "ACGT" for c in bases):
+            continue
+        to_fwd = sum(a != b for a, b in zip(bases, CANONICAL_FWD))
+        to_rev = sum(a != b for a, b in zip(bases, CANONICAL_REV))
+        if min(to_fwd, to_rev) <= edit_distance:
+            matches.append((start, 6, to_fwd < to_rev, bases in (CANONICAL_FWD, CANONICAL_REV)))
+    return matches
+
+
+def new_block(m):
+    position, size, forward, canonical = m
+    return {"start": position, "end": position + size, "prev": position, "counts": 1,
+            "forward": int(forward), "canonical": int(canonical),
+            "can_covered": size if canonical else 0}
+
+
+def extend_block(block, m, from_start=True):
+    position, size, forward, canonical = m
+    if from_start:
+        block["end"] = position + size
+    else:
+        block["start"] = position
+    block["prev"] = position
+    block["counts"] += 1
+    block["forward"] += forward
+    block["canonical"] += canonical
+    block["can_covered"] += size if canonical else 0
+
+
+def terminal_blocks(matches, size, params, from_start):
+    """Sub-blocks walked from one end inward while they start in the terminal
+    zone, merged within -d; returns the blocks and the inner boundary."""
+    limit = params["t"]
+    boundary = 0 if from_start else size
+
+    def in_zone(position):
+        return size <= limit or (position < limit if from_start else position >= size - limit)
+
+    sub_blocks, block = [], None
+
+    def close(block):
+        if (block["counts"] >= MIN_BLOCK_COUNTS and block["canonical"] > 0 and
+                block["can_covered"] >= params["y"] * (block["end"] - block["start"])):
+            sub_blocks.append(dict(block))
+
+    for m in (matches if from_start else reversed(matches)):
+        if block is not None:
+            gap = m[0] - block["prev"] if from_start else block["prev"] - m[0]
+            if gap <= params["k"]:
+                extend_block(block, m, from_start)
+                continue
+            close(block)
+            block = None
+        if not in_zone(m[0]):
+            break
+        block = new_block(m)
+    if block is not None:
+        close(block)
+
+    blocks = []
+    if not sub_blocks:
+        return blocks, boundary
+    current = sub_blocks[0]
+
+    def finalize(current):
+        nonlocal boundary
+        if current["end"] - current["start"] >= params["l"]:
+            blocks.append(dict(current, label="p" if from_start else "q"))
+            boundary = current["end"] if from_start else current["start"]
+
+    for following in sub_blocks[1:]:
+        gap = following["start"] - current["end"] if from_start else current["start"] - following["end"]
+        if gap <= params["d"]:
+            current = dict(current, start=min(current["start"], following["start"]),
+                           end=max(current["end"], following["end"]),
+                           counts=current["counts"] + following["counts"],
+                           forward=current["forward"] + following["forward"],
+                           canonical=current["canonical"] + following["canonical"],
+                           can_covered=current["can_covered"] + following["can_covered"])
+        else:
+            finalize(current)
+            current = following
+    finalize(current)
+    return blocks, boundary
+
+
+def interstitial_blocks(matches, fwd_boundary, rev_boundary, params):
+    blocks, block = [], None
+
+    def close(block):
+        forward, counts = block["forward"], block["counts"]
+        ratio = forward * 100.0 / counts
+        label = "p" if ratio > 66.6 else "q" if ratio < 33.3 else "b"
+        if (block["end"] - block["start"] >= 12 and block["canonical"] >= MIN_INTERSTITIAL_CANONICAL and
+                not (label == "b" and forward < 2 and counts - forward < 2)):
+            blocks.append(dict(block, label=label))
+
+    for m in matches:
+        if m[0] < fwd_boundary:
+            continue
+        if m[0] >= rev_boundary:
+            break
+        if block is not None and m[0] - block["prev"] <= params["k"]:
+            extend_block(block, m)
+            continue
+        if block is not None:
+            close(block)
+        block = new_block(m)
+    if block is not None:
+        close(block)
+    return blocks
+
+
+def expected_rows(records, params):
+    terminal, interstitial = [], []
+    for header, seq in records.items():
+        size = len(seq)
+        matches = find_matches(seq, params["x"])
+        forward = [m for m in matches if m[2]]
+        reverse = [m for m in matches if not m[2]]
+        blocks, fwd_boundary, rev_boundary = [], 0, size
+        if len(forward) >= 2:
+            found, fwd_boundary = terminal_blocks(forward, size, params, True)
+            blocks += found
+        if len(reverse) >= 2:
+            found, rev_boundary = terminal_blocks(reverse, size, params, False)
+            blocks += found
+        for b in blocks:
+            scaffold = b["start"] < params["t"] or b["end"] > size - params["t"]
+            terminal.append((header, b["start"], b["end"], b["end"] - b["start"], b["label"], b["forward"],
+                             b["counts"] - b["forward"], b["canonical"], b["counts"] - b["canonical"], size,
+                             "scaffold" if scaffold else "contig"))
+        if fwd_boundary < rev_boundary and len(matches) >= 2:
+            for b in interstitial_blocks(matches, fwd_boundary, rev_boundary, params):
+                interstitial.append((header, b["start"], b["end"], b["end"] - b["start"], b["label"], b["forward"],
+                                     b["counts"] - b["forward"], b["canonical"], b["counts"] - b["canonical"], size))
+    return terminal, interstitial
+
+
+def read_rows(path):
+    rows = []
+    for line in path.read_text().splitlines():
+        if not line:
+            continue
+        fields = line.split("\t")
+        rows.append(tuple(int(f) if f.isdigit() else f for f in fields))
+    return rows
+
+
+def check_case(tmp, fasta, records, params):
+    name = "_".join(f"{key}{value}" for key, value in params.items())
+    out_dir = tmp / f"out_{name}"
+    out_dir.mkdir()
+    args = [str(TELOSCOPE), "-f", str(fasta), "-o", str(out_dir), "-i", "-n", "-w", WINDOW, "-s", WINDOW]
+    for key, value in params.items():
+        args += [f"-{key}", str(value)]
+    result = subprocess.run(args, stdout=subprocess.PIPE, stderr=subprocess.PIPE, check=False, timeout=120)
+    require(result.returncode == 0,
+            f"{' '.join(args)} failed with exit {result.returncode}:\n{result.stderr.decode(errors='replace')}")
+
+    terminal, interstitial = expected_rows(records, params)
+    for suffix, wanted in (("_terminal_telomeres.bed", terminal), ("_interstitial_telomeres.bed", interstitial)):
+        paths = list(out_dir.glob(f"*{suffix}"))
+        require(len(paths) == 1, f"{suffix} not written for {' '.join(args)}")
+        found = read_rows(paths[0])
+        if suffix == "_terminal_telomeres.bed":  # sorted by start per record, ties in any order
+            found, wanted = sorted(found), sorted(wanted)
+        missing = [row for row in wanted if row not in found]
+        extra = [row for row in found if row not in wanted]
+        require(found == wanted,
+                f"{' '.join(args)}: {suffix} differs, {len(missing)} missing, {len(extra)} extra, "
+                f"first missing {missing[:2]}, first extra {extra[:2]}")
+    return len(terminal), len(interstitial)
+
+
+def main():
+    require(TELOSCOPE.exists(), f"Teloscope binary not found: {TELOSCOPE}")
+    records = make_records()
+    cases = (
+        {"x": 1, "t": 3000, "k": 50, "d": 500, "l": 300, "y": 0.5},
+        {"x": 0, "t": 3000, "k": 50, "d": 500, "l": 300, "y": 0.5},
+        {"x": 1, "t": 800, "k": 40, "d": 200, "l": 100, "y": 0.3},
+        {"x": 2, "t": 20000, "k": 60, "d": 1000, "l": 50, "y": 0.8},
+    )
+    terminal_count = interstitial_count = 0
+    with tempfile.TemporaryDirectory(prefix="teloscope_telomere_blocks_") as temp:
+        tmp = pathlib.Path(temp)
+        fasta = tmp / "blocks.fa"
+        fasta.write_text("".join(f">{header}\n{seq}\n" for header, seq in records.items()))
+        for params in cases:
+            terminal, interstitial = check_case(tmp, fasta, records, params)
+            terminal_count += terminal
+            interstitial_count += interstitial
+    require(terminal_count > 0 and interstitial_count > 0, "fixtures produced no blocks to compare")
+    print(f"PASS telomere blocks ({len(cases)} parameter sets, {terminal_count} terminal and "
+          f"{interstitial_count} interstitial blocks)")
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except Exception as error:
+        print(f"FAIL telomere blocks: {error}", file=sys.stderr)
+        raise
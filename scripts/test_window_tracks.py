@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Known-answer test for the -g and -e window tracks: runs teloscope on
+generated sequences (mixed case, IUPAC codes, N-runs) with several window
+layouts and kernels, and recomputes GC content and Shannon entropy of every
+reported window from the FASTA."""
+
+import math
+import os
+import pathlib
+import random
+import subprocess
+import sys
+import tempfile
+
+
+ROOT = pathlib.Path(__file__).resolve().parents[1]
+DEFAULT_TELOSCOPE = ROOT / "build/bin" / ("teloscope.exe" if os.name == "nt" else "teloscope")
+TELOSCOPE = pathlib.Path(os.environ.get("TELOSCOPE", DEFAULT_TELOSCOPE))
+
+GC_TOLERANCE = 1e-3       # printed with 6 significant digits
+ENTROPY_TOLERANCE = 1.1e-3  # rounded to 3 decimals in single precision
+
+
+def require(condition, message):
+    if not condition:
+        raise AssertionError(message)
+
+
+def make_records():
+    rng = random.Random(5)
+
+    def record(length, gaps):
+        # skewed composition, so windows differ in GC and entropy
+        weights = [rng.random() for _ in range(4)]
+        bases = rng.choices("ACGT", weights=weights, k=length)
+        for i in range(length):
+            pick = rng.random()
+            if pick < 0.3:
+                bases[i] = bases[i].lower()
+            elif pick < 0.32:
+                bases[i] = rng.choice("RYKMrykm")
+        for _ in range(gaps):
+            start = rng.randrange(length)
+            run = rng.randint(1, 300)
+            bases[start:start + run] = ["N"] * len(bases[start:start + run])
+        return "".join(bases)
+
+    lengths = [(1, 0), (37, 0), (130, 0), (999, 0), (1000, 0), (1001, 1), (4321, 2), (25000, 6)]
+    return {f"seq{length}": record(length, gaps) for length, gaps in lengths}
+
+
+def window_values(seq):
+    counts = [seq.count(base) + seq.count(base.lower()) for base in "ACGT"]
+    size = len(seq)
+    gc = (counts[1] + counts[2]) / size * 100.0
+    entropy = -sum(c / size * math.log2(c / size) for c in counts if c)
+    return gc, round(entropy, 3)
+
+
+def read_track(path):
+    rows = []
+    for line in path.read_text().splitlines():
+        if not line or line.startswith("track"):
+            continue
+        header, start, end, value = line.split("\t")
+        rows.append((header, int(start), int(end), float(value)))
+    return rows
+
+
+def check_tracks(out_dir, records, args, window_sizes):
+    for track, column in (("gc", 0), ("entropy", 1)):
+        paths = sorted(out_dir.glob(f"*_{track}.bedgraph"))
+        require(len(paths) == len(window_sizes),
+                f"{' '.join(args)}: expected {len(window_sizes)} {track} tracks, found {[p.name for p in paths]}")
+        for path in paths:
+            rows = read_track(path)
+            require(rows, f"{' '.join(args)}: {path.name} is empty")
+            seen = set()
+            for header, start, end, value in rows:
+                require(header in records, f"{path.name}: unknown sequence {header}")
+                seq = records[header]
+                require(0 <= start < end <= len(seq), f"{path.name}: window {header}:{start}-{end} out of range")
+                require(end - start <= max(window_sizes), f"{path.name}: window {header}:{start}-{end} too long")
+                require("N" not in seq[start:end], f"{path.name}: window {header}:{start}-{end} spans a gap")
+                expected = window_values(seq[start:end])[column]
+                tolerance = GC_TOLERANCE if track == "gc" else ENTROPY_TOLERANCE
+                require(abs(value - expected) <= tolerance,
+                        f"{' '.join(args)}: {path.name} {header}:{start}-{end} is {value}, expected {expected:.6g}")
+                seen.add(header)
+            require(seen == set(records), f"{path.name}: no windows for {sorted(set(records) - seen)}")
+
+
+def main():
+    require(TELOSCOPE.exists(), f"Teloscope binary not found: {TELOSCOPE}")
+    records = make_records()
+    layouts = (
+        # options, window sizes of the tracks written
+        (["-w", "1000", "-s", "1000"], [1000]),
+        (["-w", "1000", "-s", "300"], [1000]),
+        (["-w", "64", "-s", "64"], [64]),
+        (["-w", "500", "-s", "500", "--window-levels", "1000,5000"], [500, 1000, 5000]),
+    )
+    runs = 0
+    with tempfile.TemporaryDirectory(prefix="teloscope_window_tracks_") as temp:
+        tmp = pathlib.Path(temp)
+        fasta = tmp / "tracks.fa"
+        fasta.write_text("".join(f">{header}\n{seq}\n" for header, seq in records.items()))
+        for options, window_sizes in layouts:
+            for kernel in ("scalar", "auto"):
+                runs += 1
+                out_dir = tmp / f"out{runs}"
+                out_dir.mkdir()
+                args = [str(TELOSCOPE), "-f", str(fasta), "-o", str(out_dir), "-g", "-e",
+                        "--kernel", kernel, *options]
+                result = subprocess.run(args, stdout=subprocess.PIPE, stderr=subprocess.PIPE, check=False, timeout=120)
+                require(result.returncode == 0,
+                        f"{' '.join(args)} failed with exit {result.returncode}:\n"
+                        f"{result.stderr.decode(errors='replace')}")
+                check_tracks(out_dir, records, args, window_sizes)
+    print(f"PASS window tracks ({runs} runs, {len(records)} sequences)")
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except Exception as error:
+        print(f"FAIL window tracks: {error}", file=sys.stderr)
+        raise
@@ -0,0 +1,120 @@
+#include "approx-matcher.h"
+
+bool ApproxMatcher::build(const std::vector<std::pair<std::string, bool>>& seedInfo, uint8_t maxDistance,
+                          bool allowIndels, const std::string& canonicalFwd, const std::string& canonicalRev) {
+    words.clear();
+    seeds.clear();
+    longestSeed = 0;
+    if (seedInfo.empty() || maxDistance > maxErrors) return false;
+
+    std::vector<Seed> packed;
+    std::vector<Word> packedWords;
+    uint8_t usedBits = 64; // forces a first word
+    for (const auto& [bases, isForward] : seedInfo) {
+        if (bases.empty() || bases.size() > maxSeedLength) return false;
+        for (char c : bases) {
+            if (baseClass(c) == 0) return false;
+        }
+
+        if (usedBits + bases.size() > 64) {
+            packedWords.emplace_back();
+            usedBits = 0;
+        }
+        Word& word = packedWords.back();
+        word.startBits |= uint64_t(1) << usedBits;
+        for (size_t i = 0; i < bases.size(); ++i) {
+            const uint8_t accepted = baseClass(bases[i]);
+            for (uint8_t b = 0; b < 4; ++b) {
+                if ((accepted >> b) & 1) word.baseMasks[b] |= uint64_t(1) << (usedBits + i);
+            }
+        }
+        usedBits += static_cast<uint8_t>(bases.size());
+        word.endBits |= uint64_t(1) << (usedBits - 1);
+        word.seedAtBit[usedBits - 1] = static_cast<uint16_t>(packed.size());
+
+        Seed seed;
+        seed.bases = bases;
+        seed.isForward = isForward;
+        seed.orientByBases = countSeedCombinations(bases) > maxOrientationChecks;
+        packed.push_back(seed);
+        longestSeed = std::max<uint16_t>(longestSeed, static_cast<uint16_t>(bases.size()));
+    }
+
+    words = std::move(packedWords);
+    seeds = std::move(packed);
+    errors = maxDistance;
+    indels = allowIndels;
+    this->canonicalFwd = canonicalFwd;
+    this->canonicalRev = canonicalRev;
+    return true;
+}
+
+size_t ApproxMatcher::countWords(const std::vector<std::pair<std::string, bool>>& seedInfo) {
+    size_t count = 0;
+    size_t usedBits = 64;
+    for (const auto& seed : seedInfo) {
+        if (usedBits + seed.first.size() > 64) {
+            ++count;
+            usedBits = 0;
+        }
+        usedBits += seed.first.size();
+    }
+    return count;
+}
+
+bool ApproxMatcher::cheaperThanAutomaton(size_t words, uint8_t maxDistance, uint64_t automatonStates) {
+    // Fitted on a 20 Mbp synthetic genome (random bases with TTAGGG arrays,
+    // one thread, literal seeds of 6-64 bp at -x 0 to 2): this matcher scans
+    // at ~8 ns/base plus ~3 ns per word and error level; the automaton at
+    // ~3.5 ns/base, plus ~0.4 ns per MB of transitions past the first, and
+    // takes ~220 ns per state to enumerate and build. The build is spread
+    // over a chromosome-scale scan.
+    constexpr double referenceBases = 1e8;
+    constexpr double bytesPerState = 5 * sizeof(uint32_t); // Trie::symbols transitions
+    const double matcherNs = 8.0 + 3.0 * static_cast<double>(words) * (maxDistance + 1);
+    const double tableMB = static_cast<double>(automatonStates) * bytesPerState / 1e6;
+    const double automatonNs = 3.5 + 0.4 * std::max(0.0, tableMB - 1.0) +
+                               220.0 * static_cast<double>(automatonStates) / referenceBases;
+    return matcherNs < automatonNs;
+}
+
+uint16_t ApproxMatcher::alignStart(const char* seq, uint64_t begin, uint64_t end, const Seed& seed,
+                                   uint8_t distance) const {
+    // global alignment of the seed against text suffixes ending at `end`, both read backwards;
+    // row i holds distances for the last i seed bases against the last t text bases
+    const uint16_t seedLen = static_cast<uint16_t>(seed.bases.size());
+    uint16_t maxText = static_cast<uint16_t>(std::min<uint64_t>(seedLen + distance, end - begin + 1));
+    // non-ACGT bases reset the scan states, so no alignment reaches over them
+    for (uint16_t t = 1; t <= maxText; ++t) {
+        if (kernels::baseSymbols[static_cast<uint8_t>(seq[end + 1 - t])] > 3) {
+            maxText = t - 1;
+            break;
+        }
+    }
+    std::array<uint16_t, maxSeedLength + maxErrors + 1> row, nextRow;
+    for (uint16_t t = 0; t <= maxText; ++t) row[t] = t;
+
+    for (uint16_t i = 1; i <= seedLen; ++i) {
+        const uint8_t accepted = baseClass(seed.bases[seedLen - i]);
+        nextRow[0] = i;
+        for (uint16_t t = 1; t <= maxText; ++t) {
+            const uint8_t symbol = kernels::baseSymbols[static_cast<uint8_t>(seq[end + 1 - t])];
+            uint16_t diagonal = row[t - 1] + ((accepted >> symbol) & 1 ? 0 : 1);
+            nextRow[t] = std::min<uint16_t>(diagonal, std::min(row[t], nextRow[t - 1]) + 1);
+        }
+        row = nextRow;
+    }
+
+    // lowest distance; ties go to the length closest to the seed, then the shorter one
+    uint16_t best = seedLen;
+    uint16_t bestDistance = UINT16_MAX;
+    for (uint16_t t = 1; t <= maxText; ++t) {
+        uint16_t gap = t > seedLen ? t - seedLen : seedLen - t;
+        uint16_t bestGap = best > seedLen ? best - seedLen : seedLen - best;
+        if (row[t] < bestDistance || (row[t] == bestDistance && gap < bestGap)) {
+            best = t;
+            bestDistance = row[t];
+        }
+    }
+    return best;
+}
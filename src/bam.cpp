@@ -14,6 +14,7 @@
 
 #include "bgzf.h"
 #include "global.h"
+#include "kernels.h"
 #include "read-filter.h"
 #include "threadpool.h"
 
@@ -152,13 +153,8 @@ std::string decodeSequence(const std::vector<uint8_t> &raw) {
         throw std::runtime_error("BAM read name is not NUL-terminated");
     }
 
-    static constexpr char bases[] = "=ACMGRSVTWYHKDBN";
     std::string sequence(sequenceLength, 'N');
-    for (size_t i = 0; i < sequenceLength; ++i) {
-        const uint8_t packed = core[sequenceOffset + i / 2];
-        const uint8_t code = (i % 2 == 0) ? (packed >> 4) : (packed & 0x0f);
-        sequence[i] = bases[code];
-    }
+    kernels::active().decodeBases(core + sequenceOffset, sequenceLength, &sequence[0]);
     return sequence;
 }
 
@@ -217,7 +213,7 @@ BamSubsetStats subsetBam(std::istream &input,
                 ReadTelomereFilter filter(userInput);
                 for (size_t i = start; i < end; ++i) {
                     if (batch[i].hasSequence &&
-                        filter.matches(std::move(batch[i].sequence))) {
+                        filter.matches(batch[i].sequence)) {
                         passed[i] = 1;
                     }
                 }
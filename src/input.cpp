@@ -77,6 +77,12 @@ void queueAnnotation(std::vector<PendingTelomereAnnotation> &annotations,
     annotations.push_back({dedupeKey, header, atStart, blockLen, segOrient});
 }
 
+// Segment bases as stored, read in place: the scanners fold case themselves.
+std::string_view segmentSequence(InSegment *segment) {
+    const std::string *sequence = segment->getInSequencePtr();
+    return sequence == NULL ? std::string_view() : std::string_view(*sequence);
+}
+
 void appendTelomereConnection(InSequences &inSequences,
                               unsigned int telomereUid,
                               unsigned int segmentUid,
@@ -715,19 +721,45 @@ void Input::read(InSequences &inSequences) {
         return;
     }
 
-    // path-based annotation
+    // results go to one slot per path, ranked by seqPos, so they need no sort
+    std::vector<unsigned int> seqPositions;
+    seqPositions.reserve(inPaths.size());
+    for (InPath& inPath : inPaths) seqPositions.push_back(inPath.getSeqPos());
+    std::sort(seqPositions.begin(), seqPositions.end());
+    teloscope.reservePathSlots(inPaths.size());
+
+    // path-based annotation, longest scan first: a large scaffold late in the
+    // file would otherwise start last and run alone. Tip scans read at most
+    // 2 * -t per segment. Ties keep file order.
+    struct PathJob { uint64_t scanLength; InPath* path; size_t slot; };
+    std::vector<PathJob> pathJobs;
+    pathJobs.reserve(inPaths.size());
     for (InPath& inPath : inPaths) {
-        InPath* pathPtr = &inPath;
-        threadPool.queueJob([pathPtr, inSegments, inGaps, &teloscope]() {
-            return teloscope.walkPath(pathPtr, *inSegments, *inGaps);
+        uint64_t scanLength = inPath.getLen();
+        if (userInput.ultraFastMode) {
+            uint64_t segments = 0;
+            for (const PathComponent& component : inPath.getComponents())
+                segments += component.componentType == SEGMENT;
+            scanLength = std::min(scanLength, segments * 2 * userInput.terminalLimit);
+        }
+        size_t slot = std::lower_bound(seqPositions.begin(), seqPositions.end(), inPath.getSeqPos()) - seqPositions.begin();
+        pathJobs.push_back({scanLength, &inPath, slot});
+    }
+    std::stable_sort(pathJobs.begin(), pathJobs.end(), [](const PathJob& one, const PathJob& two) {
+        return one.scanLength > two.scanLength;
+    });
+
+    for (const PathJob& job : pathJobs) {
+        InPath* pathPtr = job.path;
+        size_t slot = job.slot;
+        threadPool.queueJob([pathPtr, slot, inSegments, inGaps, &teloscope]() {
+            return teloscope.walkPath(pathPtr, slot, *inSegments, *inGaps);
         });
     }
     lg.verbose("Waiting for jobs to complete");
     jobWait(threadPool);
     lg.verbose("\nAll jobs completed.");
-
-    teloscope.sortBySeqPos();
-    lg.verbose("\nPaths sorted by original position.");
+    teloscope.printPathLogs();
 
     teloscope.handleBEDFile();
     lg.verbose("\nReport and BED/BEDgraph files generated.");
@@ -836,10 +868,10 @@ bool Teloscope::walkSegment(InSegment* segment, InSequences& inSequences) {
     Log threadLog;
     threadLog.add("\n\tWalking segment:\t" + segment->getSeqHeader());
 
-    std::string sequence = segment->getInSequence(0, 0);
-    unmaskSequence(sequence);
+    std::string_view sequence = segmentSequence(segment);
 
-    SegmentData segmentData = scanSegment(sequence, 0, true); // tipsOnly = true for GFA segments
+    thread_local SegmentData segmentData; // reused by every segment walked on this worker
+    scanSegment(sequence, 0, true, segmentData); // tipsOnly = true for GFA segments
 
     std::vector<PendingTelomereAnnotation> annotations;
 
@@ -886,10 +918,10 @@ bool Teloscope::walkSegmentForPath(InSegment* segment, InSequences& inSequences,
     Log threadLog;
     threadLog.add("\n\tWalking segment (path-aware):\t" + segment->getSeqHeader());
 
-    std::string sequence = segment->getInSequence(0, 0);
-    unmaskSequence(sequence);
+    std::string_view sequence = segmentSequence(segment);
 
-    SegmentData segmentData = scanSegment(sequence, 0, true);
+    thread_local SegmentData segmentData; // reused by every segment walked on this worker
+    scanSegment(sequence, 0, true, segmentData);
 
     // Physical end holding the path-terminal tip (start when isFirst == (orient=='+')).
     bool scanStart = (isFirst == (pathOrient == '+'));
@@ -939,7 +971,7 @@ bool Teloscope::walkSegmentForPath(InSegment* segment, InSequences& inSequences,
 }
 
 
-bool Teloscope::walkPath(InPath* path, std::vector<InSegment*> &inSegments, std::vector<InGap> &inGaps) {
+bool Teloscope::walkPath(InPath* path, size_t slot, std::vector<InSegment*> &inSegments, std::vector<InGap> &inGaps) {
     Log threadLog;
     uint64_t absPos = 0;
     unsigned int cUId = 0, gapLen = 0, seqPos = path->getSeqPos();
@@ -954,60 +986,108 @@ bool Teloscope::walkPath(InPath* path, std::vector<InSegment*> &inSegments, std:
     pathData.seqPos = seqPos;
     pathData.header = header;
     pathData.pathSize = path->getLen();
-    // pathData.windows.reserve(inSegments.size()); NumWindows = ceil((L - W) / S) + 1
 
-    // index for O(1) lookups
-    std::unordered_map<unsigned int, InSegment*> segmentIndex;
-    segmentIndex.reserve(inSegments.size());
-    for (auto* seg : inSegments) segmentIndex[seg->getuId()] = seg;
+    // windows of this path per level until they are spilled at the end of the walk
+    const size_t levelCount = windowLevelCount();
+    thread_local std::vector<std::vector<WindowRecord>> windows;
+    windows.resize(levelCount);
+    for (auto& level : windows) level.clear();
+    std::vector<uint64_t> lastWindowStart(levelCount, 0); // absolute start of the last window collected
+    pathData.windows.resize(levelCount);
+    if (!userInput.ultraFastMode && !memoryBudget.bounded()) {
+        for (size_t level = 0; level < levelCount; ++level) {
+            windows[level].reserve(pathData.pathSize / windowLevelStep(level) + pathComponents.size());
+        }
+    }
+    auto spillWindows = [&]() {
+        for (size_t level = 0; level < levelCount; ++level) {
+            if (windows[level].empty()) continue;
+            pathData.windows[level].push_back(spill.append(windows[level]));
+            windows[level].clear();
+        }
+    };
+
+    // --max-memory: the windows and matches of this path are held against the
+    // budget as they grow; a path that does not fit spills what it has so far
+    uint64_t reserved = 0;
+    auto holdPathData = [&]() {
+        if (!memoryBudget.bounded()) return;
+        uint64_t bytes = pathData.matches.memoryUsage();
+        for (const auto& level : windows) bytes += level.size() * sizeof(WindowRecord);
+        if (bytes <= reserved || memoryBudget.reserve(bytes - reserved)) {
+            memoryBudget.release(reserved > bytes ? reserved - bytes : 0);
+            reserved = bytes;
+            return;
+        }
+        spillWindows();
+        if (!pathData.matches.empty()) {
+            thread_local std::string matchBytes;
+            matchBytes.clear();
+            pathData.matches.serialize(matchBytes);
+            pathData.spilledMatches.push_back(spill.append(matchBytes.data(), matchBytes.size()));
+            pathData.matches = MatchStore();
+        }
+        memoryBudget.release(reserved);
+        reserved = 0;
+    };
 
-    std::unordered_map<unsigned int, InGap*> gapIndex;
-    gapIndex.reserve(inGaps.size());
-    for (auto& gap : inGaps) gapIndex[gap.getuId()] = &gap;
+    // index for O(1) lookups, shared by all paths
+    std::call_once(componentIndexOnce, [&]() {
+        segmentIndex.reserve(inSegments.size());
+        for (auto* seg : inSegments) segmentIndex[seg->getuId()] = seg;
+
+        gapIndex.reserve(inGaps.size());
+        for (auto& gap : inGaps) gapIndex[gap.getuId()] = &gap;
+    });
+
+    thread_local SegmentData segmentData; // scan buffers, reused across segments and paths on this worker
 
     for (std::vector<PathComponent>::iterator component = pathComponents.begin(); component != pathComponents.end(); component++) {
         cUId = component->id;
 
         if (component->componentType == SEGMENT) {
             auto inSegment = segmentIndex.find(cUId)->second;
-            std::string sequence = inSegment->getInSequence(component->start, component->end);
-            unmaskSequence(sequence);
+            // whole segments are scanned in place, only subranges are copied out
+            std::string subsequence;
+            std::string_view sequence;
+            if (component->start == 0 && component->end == 0) {
+                sequence = segmentSequence(inSegment);
+            } else {
+                subsequence = inSegment->getInSequence(component->start, component->end);
+                sequence = subsequence;
+            }
             
             if (component->orientation == '+') {
-                SegmentData segmentData = scanSegment(sequence, absPos, userInput.ultraFastMode);
-
-                // Collect window data
-                pathData.windows.insert(
-                    pathData.windows.end(),
-                    std::make_move_iterator(segmentData.windows.begin()),
-                    std::make_move_iterator(segmentData.windows.end())
-                );
+                scanSegment(sequence, absPos, userInput.ultraFastMode, segmentData);
+
+                // Collect window data, rebasing the first start on the previous window;
+                // a distance past the 32-bit delta is carried by empty skip records
+                for (size_t level = 0; level < segmentData.windows.size(); ++level) {
+                    const auto& segmentWindows = segmentData.windows[level];
+                    if (segmentWindows.empty()) continue;
+                    uint64_t delta = absPos - lastWindowStart[level];
+                    for (; delta > UINT32_MAX; delta -= UINT32_MAX) {
+                        WindowRecord skip;
+                        skip.startDelta = UINT32_MAX;
+                        windows[level].push_back(skip);
+                    }
+                    const size_t first = windows[level].size();
+                    windows[level].insert(windows[level].end(), segmentWindows.begin(), segmentWindows.end());
+                    windows[level][first].startDelta = static_cast<uint32_t>(delta);
+                    lastWindowStart[level] = absPos + static_cast<uint64_t>(segmentWindows.size() - 1) * windowLevelStep(level);
+                }
 
                 // Collect blocks
-                pathData.terminalBlocks.insert(
-                    pathData.terminalBlocks.end(),
-                    std::make_move_iterator(segmentData.terminalBlocks.begin()),
-                    std::make_move_iterator(segmentData.terminalBlocks.end())
-                );
-
-                pathData.interstitialBlocks.insert(
-                    pathData.interstitialBlocks.end(),
-                    std::make_move_iterator(segmentData.interstitialBlocks.begin()),
-                    std::make_move_iterator(segmentData.interstitialBlocks.end())
-                );
+                pathData.terminalBlocks.insert(pathData.terminalBlocks.end(),
+                                               segmentData.terminalBlocks.begin(), segmentData.terminalBlocks.end());
+
+                pathData.interstitialBlocks.insert(pathData.interstitialBlocks.end(),
+                                                   segmentData.interstitialBlocks.begin(), segmentData.interstitialBlocks.end());
 
                 // Collect matches
-                pathData.canonicalMatches.insert(
-                    pathData.canonicalMatches.end(),
-                    std::make_move_iterator(segmentData.canonicalMatches.begin()),
-                    std::make_move_iterator(segmentData.canonicalMatches.end())
-                );
-
-                pathData.nonCanonicalMatches.insert(
-                    pathData.nonCanonicalMatches.end(),
-                    std::make_move_iterator(segmentData.nonCanonicalMatches.begin()),
-                    std::make_move_iterator(segmentData.nonCanonicalMatches.end())
-                );
+                pathData.matches.append(segmentData.matches.reported());
+                pathData.canonicalCount += segmentData.canonicalCount;
+                holdPathData();
 
             } else {
             }
@@ -1031,11 +1111,24 @@ bool Teloscope::walkPath(InPath* path, std::vector<InSegment*> &inSegments, std:
     labelTerminalBlocks(pathData.terminalBlocks, static_cast<uint16_t>(pathData.gapInfos.size()),
                         pathData.terminalLabel, pathData.scaffoldType,
                         pathData.pathSize, userInput.terminalLimit);
+    spillWindows();
+    holdPathData();
     threadLog.add("\tCompleted walking path:\t" + path->getHeader());
 
-    std::lock_guard<std::mutex> lck(mtx);
-    allPathData.push_back(std::move(pathData));
-    logs.push_back(threadLog);
+    // the slot is this path's alone, so no lock is taken
+    allPathData[slot] = std::move(pathData);
+    pathLogs[slot] = threadLog;
 
     return true;
 }
+
+
+void Teloscope::printPathLogs() {
+    if (verbose_flag) {
+        for (Log& pathLog : pathLogs) {
+            pathLog.print();
+            std::cerr << "\n";
+        }
+    }
+    pathLogs.clear();
+}
@@ -0,0 +1,434 @@
+#include "kernels.h"
+
+#include <algorithm>
+#include <array>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw,popcnt")))
+#endif
+
+namespace kernels {
+
+namespace {
+
+constexpr char bamBases[] = "=ACMGRSVTWYHKDBN";
+constexpr char lowerBit = 0x20; // 'A' | lowerBit == 'a'; maps no other byte onto a lowercase base
+
+// ========== Scalar ==========
+
+void countBasesScalar(const char *seq, uint64_t length, uint32_t counts[4]) {
+    for (uint64_t i = 0; i < length; ++i) {
+        switch (seq[i]) {
+            case 'A': case 'a': ++counts[0]; break;
+            case 'C': case 'c': ++counts[1]; break;
+            case 'G': case 'g': ++counts[2]; break;
+            case 'T': case 't': ++counts[3]; break;
+            default: break;
+        }
+    }
+}
+
+void decodeBasesScalar(const uint8_t *packed, uint64_t length, char *out) {
+    for (uint64_t i = 0; i < length; ++i) {
+        const uint8_t byte = packed[i / 2];
+        out[i] = bamBases[(i % 2 == 0) ? (byte >> 4) : (byte & 0x0f)];
+    }
+}
+
+uint64_t nextBaseScalar(const char *seq, uint64_t pos, uint64_t end) {
+    while (pos < end && baseSymbols[static_cast<uint8_t>(seq[pos])] > 3) ++pos;
+    return pos;
+}
+
+uint64_t periodMaskScalar(const char *seq, uint64_t pos, uint64_t end, uint32_t period) {
+    uint64_t mask = 0;
+    const uint64_t last = end > pos + period ? std::min<uint64_t>(64, end - pos - period) : 0;
+    for (uint64_t i = 0; i < last; ++i) {
+        const uint8_t symbol = baseSymbols[static_cast<uint8_t>(seq[pos + i])];
+        if (symbol < 4 && symbol == baseSymbols[static_cast<uint8_t>(seq[pos + i + period])]) {
+            mask |= uint64_t(1) << i;
+        }
+    }
+    return mask;
+}
+
+bool anchorAt(const char *seq, const char *anchors, uint32_t anchorCount, uint8_t anchorLen) {
+    for (uint32_t a = 0; a < anchorCount; ++a) {
+        const char *anchor = anchors + a * anchorStride;
+        uint8_t t = 0;
+        while (t < anchorLen && (seq[t] | lowerBit) == anchor[t]) ++t;
+        if (t == anchorLen) return true;
+    }
+    return false;
+}
+
+uint64_t findAnchorScalar(const char *seq, uint64_t pos, uint64_t end,
+                          const char *anchors, uint32_t anchorCount, uint8_t anchorLen) {
+    for (; pos + anchorLen <= end; ++pos) {
+        if (anchorAt(seq + pos, anchors, anchorCount, anchorLen)) return pos;
+    }
+    return end;
+}
+
+const KernelSet scalarKernels = {
+    Level::scalar, "scalar", 1,
+    countBasesScalar, decodeBasesScalar, nextBaseScalar, periodMaskScalar, findAnchorScalar
+};
+
+#ifdef KERNELS_X86
+
+// ========== SSE2 ==========
+
+TARGET_SSE2 uint32_t sumBytes(__m128i acc) {
+    __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4));
+}
+
+TARGET_SSE2 void countBasesSse2(const char *seq, uint64_t length, uint32_t counts[4]) {
+    const __m128i a = _mm_set1_epi8('a'), c = _mm_set1_epi8('c');
+    const __m128i g = _mm_set1_epi8('g'), t = _mm_set1_epi8('t');
+    const __m128i lower = _mm_set1_epi8(lowerBit);
+    const uint64_t vectorEnd = length & ~uint64_t(15);
+    uint64_t i = 0;
+    while (i < vectorEnd) {
+        // byte counters overflow after 255 steps
+        const uint64_t blockEnd = std::min(vectorEnd, i + 255 * 16);
+        __m128i accA = _mm_setzero_si128(), accC = accA, accG = accA, accT = accA;
+        for (; i < blockEnd; i += 16) {
+            __m128i v = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(seq + i)), lower);
+            accA = _mm_sub_epi8(accA, _mm_cmpeq_epi8(v, a));
+            accC = _mm_sub_epi8(accC, _mm_cmpeq_epi8(v, c));
+            accG = _mm_sub_epi8(accG, _mm_cmpeq_epi8(v, g));
+            accT = _mm_sub_epi8(accT, _mm_cmpeq_epi8(v, t));
+        }
+        counts[0] += sumBytes(accA);
+        counts[1] += sumBytes(accC);
+        counts[2] += sumBytes(accG);
+        counts[3] += sumBytes(accT);
+    }
+    countBasesScalar(seq + i, length - i, counts);
+}
+
+// no byte shuffle before SSSE3: decode one packed byte into two chars at a time
+void decodeBasesPairs(const uint8_t *packed, uint64_t length, char *out) {
+    static const auto pairs = [] {
+        std::array<std::array<char, 2>, 256> table{};
+        for (int byte = 0; byte < 256; ++byte) table[byte] = {bamBases[byte >> 4], bamBases[byte & 0x0f]};
+        return table;
+    }();
+    const uint64_t fullBytes = length / 2;
+    for (uint64_t i = 0; i < fullBytes; ++i) {
+        out[2 * i] = pairs[packed[i]][0];
+        out[2 * i + 1] = pairs[packed[i]][1];
+    }
+    if (length % 2) out[length - 1] = bamBases[packed[fullBytes] >> 4];
+}
+
+TARGET_SSE2 uint64_t nextBaseSse2(const char *seq, uint64_t pos, uint64_t end) {
+    const __m128i a = _mm_set1_epi8('a'), c = _mm_set1_epi8('c');
+    const __m128i g = _mm_set1_epi8('g'), t = _mm_set1_epi8('t');
+    const __m128i lower = _mm_set1_epi8(lowerBit);
+    for (; pos + 16 <= end; pos += 16) {
+        __m128i v = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(seq + pos)), lower);
+        __m128i bases = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, a), _mm_cmpeq_epi8(v, c)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(v, g), _mm_cmpeq_epi8(v, t)));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(bases));
+        if (mask) return pos + __builtin_ctz(mask);
+    }
+    return nextBaseScalar(seq, pos, end);
+}
+
+TARGET_SSE2 uint64_t periodMaskSse2(const char *seq, uint64_t pos, uint64_t end, uint32_t period) {
+    if (pos + 64 + period > end) return periodMaskScalar(seq, pos, end, period);
+    const __m128i a = _mm_set1_epi8('a'), c = _mm_set1_epi8('c');
+    const __m128i g = _mm_set1_epi8('g'), t = _mm_set1_epi8('t');
+    const __m128i lower = _mm_set1_epi8(lowerBit);
+    uint64_t mask = 0;
+    for (uint32_t i = 0; i < 64; i += 16) {
+        __m128i v = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(seq + pos + i)), lower);
+        __m128i w = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(seq + pos + i + period)), lower);
+        __m128i bases = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, a), _mm_cmpeq_epi8(v, c)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(v, g), _mm_cmpeq_epi8(v, t)));
+        uint64_t same = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v, w), bases)));
+        mask |= same << i;
+    }
+    return mask;
+}
+
+TARGET_SSE2 uint64_t findAnchorSse2(const char *seq, uint64_t pos, uint64_t end,
+                                    const char *anchors, uint32_t anchorCount, uint8_t anchorLen) {
+    const __m128i lower = _mm_set1_epi8(lowerBit);
+    while (pos + 16 + anchorLen - 1 <= end) {
+        __m128i shifted[anchorStride];
+        for (uint8_t t = 0; t < anchorLen; ++t) {
+            shifted[t] = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(seq + pos + t)), lower);
+        }
+        __m128i hits = _mm_setzero_si128();
+        for (uint32_t a = 0; a < anchorCount; ++a) {
+            const char *anchor = anchors + a * anchorStride;
+            __m128i all = _mm_cmpeq_epi8(shifted[0], _mm_set1_epi8(anchor[0]));
+            for (uint8_t t = 1; t < anchorLen; ++t) {
+                all = _mm_and_si128(all, _mm_cmpeq_epi8(shifted[t], _mm_set1_epi8(anchor[t])));
+            }
+            hits = _mm_or_si128(hits, all);
+        }
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        if (mask) return pos + __builtin_ctz(mask);
+        pos += 16;
+    }
+    return findAnchorScalar(seq, pos, end, anchors, anchorCount, anchorLen);
+}
+
+const KernelSet sse2Kernels = {
+    Level::sse2, "sse2", 16,
+    countBasesSse2, decodeBasesPairs, nextBaseSse2, periodMaskSse2, findAnchorSse2
+};
+
+// ========== AVX2 ==========
+
+TARGET_AVX2 uint32_t sumBytes(__m256i acc) {
+    __m256i sums = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+    __m128i halves = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(halves) + _mm_extract_epi16(halves, 4));
+}
+
+TARGET_AVX2 void countBasesAvx2(const char *seq, uint64_t length, uint32_t counts[4]) {
+    const __m256i a = _mm256_set1_epi8('a'), c = _mm256_set1_epi8('c');
+    const __m256i g = _mm256_set1_epi8('g'), t = _mm256_set1_epi8('t');
+    const __m256i lower = _mm256_set1_epi8(lowerBit);
+    const uint64_t vectorEnd = length & ~uint64_t(31);
+    uint64_t i = 0;
+    while (i < vectorEnd) {
+        // byte counters overflow after 255 steps
+        const uint64_t blockEnd = std::min(vectorEnd, i + 255 * 32);
+        __m256i accA = _mm256_setzero_si256(), accC = accA, accG = accA, accT = accA;
+        for (; i < blockEnd; i += 32) {
+            __m256i v = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(seq + i)), lower);
+            accA = _mm256_sub_epi8(accA, _mm256_cmpeq_epi8(v, a));
+            accC = _mm256_sub_epi8(accC, _mm256_cmpeq_epi8(v, c));
+            accG = _mm256_sub_epi8(accG, _mm256_cmpeq_epi8(v, g));
+            accT = _mm256_sub_epi8(accT, _mm256_cmpeq_epi8(v, t));
+        }
+        counts[0] += sumBytes(accA);
+        counts[1] += sumBytes(accC);
+        counts[2] += sumBytes(accG);
+        counts[3] += sumBytes(accT);
+    }
+    countBasesScalar(seq + i, length - i, counts);
+}
+
+TARGET_AVX2 void decodeBasesAvx2(const uint8_t *packed, uint64_t length, char *out) {
+    const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bamBases)));
+    const __m256i lowNibble = _mm256_set1_epi8(0x0f);
+    uint64_t i = 0; // output position, 32 packed bytes per step
+    for (; i + 64 <= length; i += 64) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(packed + i / 2));
+        __m256i high = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibble));
+        __m256i low = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, lowNibble));
+        __m256i first = _mm256_unpacklo_epi8(high, low);  // packed bytes 0-7 | 16-23
+        __m256i second = _mm256_unpackhi_epi8(high, low); // packed bytes 8-15 | 24-31
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    decodeBasesPairs(packed + i / 2, length - i, out + i);
+}
+
+TARGET_AVX2 uint64_t nextBaseAvx2(const char *seq, uint64_t pos, uint64_t end) {
+    const __m256i a = _mm256_set1_epi8('a'), c = _mm256_set1_epi8('c');
+    const __m256i g = _mm256_set1_epi8('g'), t = _mm256_set1_epi8('t');
+    const __m256i lower = _mm256_set1_epi8(lowerBit);
+    for (; pos + 32 <= end; pos += 32) {
+        __m256i v = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(seq + pos)), lower);
+        __m256i bases = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, a), _mm256_cmpeq_epi8(v, c)),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(v, g), _mm256_cmpeq_epi8(v, t)));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(bases));
+        if (mask) return pos + __builtin_ctz(mask);
+    }
+    return nextBaseSse2(seq, pos, end);
+}
+
+TARGET_AVX2 uint64_t periodMaskAvx2(const char *seq, uint64_t pos, uint64_t end, uint32_t period) {
+    if (pos + 64 + period > end) return periodMaskScalar(seq, pos, end, period);
+    const __m256i a = _mm256_set1_epi8('a'), c = _mm256_set1_epi8('c');
+    const __m256i g = _mm256_set1_epi8('g'), t = _mm256_set1_epi8('t');
+    const __m256i lower = _mm256_set1_epi8(lowerBit);
+    uint64_t mask = 0;
+    for (uint32_t i = 0; i < 64; i += 32) {
+        __m256i v = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(seq + pos + i)), lower);
+        __m256i w = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(seq + pos + i + period)), lower);
+        __m256i bases = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, a), _mm256_cmpeq_epi8(v, c)),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(v, g), _mm256_cmpeq_epi8(v, t)));
+        uint64_t same = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(v, w), bases)));
+        mask |= same << i;
+    }
+    return mask;
+}
+
+TARGET_AVX2 uint64_t findAnchorAvx2(const char *seq, uint64_t pos, uint64_t end,
+                                    const char *anchors, uint32_t anchorCount, uint8_t anchorLen) {
+    const __m256i lower = _mm256_set1_epi8(lowerBit);
+    while (pos + 32 + anchorLen - 1 <= end) {
+        __m256i shifted[anchorStride];
+        for (uint8_t t = 0; t < anchorLen; ++t) {
+            shifted[t] = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(seq + pos + t)), lower);
+        }
+        __m256i hits = _mm256_setzero_si256();
+        for (uint32_t a = 0; a < anchorCount; ++a) {
+            const char *anchor = anchors + a * anchorStride;
+            __m256i all = _mm256_cmpeq_epi8(shifted[0], _mm256_set1_epi8(anchor[0]));
+            for (uint8_t t = 1; t < anchorLen; ++t) {
+                all = _mm256_and_si256(all, _mm256_cmpeq_epi8(shifted[t], _mm256_set1_epi8(anchor[t])));
+            }
+            hits = _mm256_or_si256(hits, all);
+        }
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        if (mask) return pos + __builtin_ctz(mask);
+        pos += 32;
+    }
+    return findAnchorScalar(seq, pos, end, anchors, anchorCount, anchorLen);
+}
+
+const KernelSet avx2Kernels = {
+    Level::avx2, "avx2", 32,
+    countBasesAvx2, decodeBasesAvx2, nextBaseAvx2, periodMaskAvx2, findAnchorAvx2
+};
+
+// ========== AVX-512 ==========
+
+TARGET_AVX512 void countBasesAvx512(const char *seq, uint64_t length, uint32_t counts[4]) {
+    const __m512i a = _mm512_set1_epi8('a'), c = _mm512_set1_epi8('c');
+    const __m512i g = _mm512_set1_epi8('g'), t = _mm512_set1_epi8('t');
+    const __m512i lower = _mm512_set1_epi8(lowerBit);
+    for (uint64_t i = 0; i < length; i += 64) {
+        const __mmask64 valid = (length - i >= 64) ? ~__mmask64(0) : (__mmask64(1) << (length - i)) - 1;
+        __m512i v = _mm512_or_si512(_mm512_maskz_loadu_epi8(valid, seq + i), lower);
+        counts[0] += static_cast<uint32_t>(__builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(valid, v, a)));
+        counts[1] += static_cast<uint32_t>(__builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(valid, v, c)));
+        counts[2] += static_cast<uint32_t>(__builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(valid, v, g)));
+        counts[3] += static_cast<uint32_t>(__builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(valid, v, t)));
+    }
+}
+
+TARGET_AVX512 uint64_t nextBaseAvx512(const char *seq, uint64_t pos, uint64_t end) {
+    const __m512i a = _mm512_set1_epi8('a'), c = _mm512_set1_epi8('c');
+    const __m512i g = _mm512_set1_epi8('g'), t = _mm512_set1_epi8('t');
+    const __m512i lower = _mm512_set1_epi8(lowerBit);
+    for (; pos < end; pos += 64) {
+        const __mmask64 valid = (end - pos >= 64) ? ~__mmask64(0) : (__mmask64(1) << (end - pos)) - 1;
+        __m512i v = _mm512_or_si512(_mm512_maskz_loadu_epi8(valid, seq + pos), lower);
+        __mmask64 bases = _mm512_mask_cmpeq_epi8_mask(valid, v, a) | _mm512_mask_cmpeq_epi8_mask(valid, v, c) |
+                          _mm512_mask_cmpeq_epi8_mask(valid, v, g) | _mm512_mask_cmpeq_epi8_mask(valid, v, t);
+        if (bases) return pos + __builtin_ctzll(bases);
+    }
+    return end;
+}
+
+TARGET_AVX512 uint64_t periodMaskAvx512(const char *seq, uint64_t pos, uint64_t end, uint32_t period) {
+    if (pos + 64 + period > end) return periodMaskScalar(seq, pos, end, period);
+    const __m512i lower = _mm512_set1_epi8(lowerBit);
+    __m512i v = _mm512_or_si512(_mm512_loadu_si512(seq + pos), lower);
+    __m512i w = _mm512_or_si512(_mm512_loadu_si512(seq + pos + period), lower);
+    __mmask64 bases = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('a')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('c')) |
+                      _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('g')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('t'));
+    return _mm512_mask_cmpeq_epi8_mask(bases, v, w);
+}
+
+TARGET_AVX512 uint64_t findAnchorAvx512(const char *seq, uint64_t pos, uint64_t end,
+                                        const char *anchors, uint32_t anchorCount, uint8_t anchorLen) {
+    const __m512i lower = _mm512_set1_epi8(lowerBit);
+    while (pos + 64 + anchorLen - 1 <= end) {
+        __m512i shifted[anchorStride];
+        for (uint8_t t = 0; t < anchorLen; ++t) {
+            shifted[t] = _mm512_or_si512(_mm512_loadu_si512(seq + pos + t), lower);
+        }
+        __mmask64 hits = 0;
+        for (uint32_t a = 0; a < anchorCount; ++a) {
+            const char *anchor = anchors + a * anchorStride;
+            __mmask64 all = _mm512_cmpeq_epi8_mask(shifted[0], _mm512_set1_epi8(anchor[0]));
+            for (uint8_t t = 1; t < anchorLen; ++t) {
+                all &= _mm512_cmpeq_epi8_mask(shifted[t], _mm512_set1_epi8(anchor[t]));
+            }
+            hits |= all;
+        }
+        if (hits) return pos + __builtin_ctzll(hits);
+        pos += 64;
+    }
+    return findAnchorAvx2(seq, pos, end, anchors, anchorCount, anchorLen);
+}
+
+// the nibble decode needs a cross-lane byte permute (VBMI) to gain over AVX2
+const KernelSet avx512Kernels = {
+    Level::avx512, "avx512", 64,
+    countBasesAvx512, decodeBasesAvx2, nextBaseAvx512, periodMaskAvx512, findAnchorAvx512
+};
+
+#endif // KERNELS_X86
+
+bool isSupported(Level level) {
+#ifdef KERNELS_X86
+    __builtin_cpu_init(); // detection can run from static initialisation, before main
+#endif
+    switch (level) {
+        case Level::scalar: return true;
+#ifdef KERNELS_X86
+        case Level::sse2: return __builtin_cpu_supports("sse2");
+        case Level::avx2: return __builtin_cpu_supports("avx2");
+        case Level::avx512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+        default: return false;
+    }
+}
+
+const KernelSet *getKernels(Level level) {
+    switch (level) {
+#ifdef KERNELS_X86
+        case Level::sse2: return &sse2Kernels;
+        case Level::avx2: return &avx2Kernels;
+        case Level::avx512: return &avx512Kernels;
+#endif
+        default: return &scalarKernels;
+    }
+}
+
+const Level levels[] = {Level::avx512, Level::avx2, Level::sse2, Level::scalar}; // best first
+
+const KernelSet *detect() {
+    for (Level level : levels) {
+        if (isSupported(level)) return getKernels(level);
+    }
+    return &scalarKernels;
+}
+
+} // namespace
+
+const KernelSet *current = detect();
+
+bool select(const std::string &name) {
+    if (name == "auto") {
+        current = detect();
+        return true;
+    }
+    for (Level level : levels) {
+        if (isSupported(level) && name == getKernels(level)->name) {
+            current = getKernels(level);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string supported() {
+    std::string names;
+    for (Level level : levels) {
+        if (!isSupported(level)) continue;
+        if (!names.empty()) names += ", ";
+        names += getKernels(level)->name;
+    }
+    return names;
+}
+
+} // namespace kernels
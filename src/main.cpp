@@ -1,5 +1,8 @@
 #include "main.h"
 #include "bam.h"
+#include "kernels.h"
+#include "approx-matcher.h"
+#include "match-store.h"
 #include <input.h>
 #include <iostream>
 
@@ -176,6 +179,12 @@ int main(int argc, char **argv) {
         {"plot-report", no_argument, 0, 0},
         {"fastq-subset", no_argument, 0, 0},
         {"bam-subset", no_argument, 0, 0},
+        {"kernel", required_argument, 0, 0},
+        {"indels", no_argument, 0, 0},
+        {"adaptive-extent", required_argument, 0, 0},
+        {"periodic-scan", no_argument, 0, 0},
+        {"max-memory", required_argument, 0, 0},
+        {"window-levels", required_argument, 0, 0},
         {"verbose", no_argument, &verbose_flag, 1},
         {"cmd", no_argument, &cmd_flag, 1},
         {"version", no_argument, 0, 'v'},
@@ -221,6 +230,61 @@ int main(int argc, char **argv) {
                     addPrefixFilters(optarg, userInput.includePrefixes, "--include-prefix");
                 else if (strcmp(long_options[option_index].name, "exclude-prefix") == 0)
                     addPrefixFilters(optarg, userInput.excludePrefixes, "--exclude-prefix");
+                else if (strcmp(long_options[option_index].name, "indels") == 0)
+                    userInput.indels = true;
+                else if (strcmp(long_options[option_index].name, "periodic-scan") == 0)
+                    userInput.periodicScan = true;
+                else if (strcmp(long_options[option_index].name, "adaptive-extent") == 0) {
+                    try {
+                        int v = std::stoi(optarg);
+                        if (v <= 0) {
+                            fprintf(stderr, "Error: Adaptive extent (--adaptive-extent) must be > 0.\n");
+                            exit(EXIT_FAILURE);
+                        }
+                        userInput.adaptiveExtent = static_cast<uint32_t>(v);
+                    } catch (...) {
+                        fprintf(stderr, "Error: Invalid adaptive extent '%s'. Must be a number.\n", optarg);
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                else if (strcmp(long_options[option_index].name, "window-levels") == 0) {
+                    std::istringstream stream(optarg);
+                    std::string level;
+                    userInput.windowLevels.clear();
+                    while (std::getline(stream, level, ',')) {
+                        try {
+                            int v = std::stoi(level);
+                            if (v <= 0) throw std::invalid_argument(level);
+                            userInput.windowLevels.push_back(static_cast<uint32_t>(v));
+                        } catch (...) {
+                            fprintf(stderr, "Error: Invalid window level '%s'. Must be a number > 0.\n", level.c_str());
+                            exit(EXIT_FAILURE);
+                        }
+                    }
+                    std::sort(userInput.windowLevels.begin(), userInput.windowLevels.end());
+                    userInput.windowLevels.erase(std::unique(userInput.windowLevels.begin(), userInput.windowLevels.end()),
+                                                 userInput.windowLevels.end());
+                }
+                else if (strcmp(long_options[option_index].name, "max-memory") == 0) {
+                    try {
+                        double v = std::stod(optarg);
+                        if (v <= 0) {
+                            fprintf(stderr, "Error: Memory budget (--max-memory) must be > 0.\n");
+                            exit(EXIT_FAILURE);
+                        }
+                        userInput.maxMem = v;
+                    } catch (...) {
+                        fprintf(stderr, "Error: Invalid memory budget '%s'. Must be a number of GB.\n", optarg);
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                else if (strcmp(long_options[option_index].name, "kernel") == 0) {
+                    if (!kernels::select(optarg)) {
+                        fprintf(stderr, "Error: Kernel '%s' is unknown or unsupported on this CPU. Available: auto, %s.\n",
+                                optarg, kernels::supported().c_str());
+                        exit(EXIT_FAILURE);
+                    }
+                }
                 break;
 
 
@@ -531,11 +595,14 @@ int main(int argc, char **argv) {
                 printf("\t'-p'\t--patterns\tSet patterns to explore, separate them by commas [Default: TTAGGG]\n");
                 printf("\t'-j'\t--threads\tSet maximum number of threads. [Default: max. available]\n");
                 printf("\t'-t'\t--terminal-limit\tSet terminal limit for exploring telomere variant regions (TVRs). [Default: 50000]\n");
+                printf("\t\t--adaptive-extent\tIn ultra-fast mode, stop scanning a tip once no block chain is open and this many bp (at least -d) pass the last sub-block, up to -t. [Default: unset (scan -t)]\n");
                 printf("\t'-k'\t--max-match-distance\tSet maximum distance for merging matches. [Default: 50]\n");
                 printf("\t'-d'\t--max-block-distance\tSet maximum block distance for extension. [Default: 500]\n");
                 printf("\t'-l'\t--min-block-length\tSet minimum block length. [Default: 300 assembly, 42 read subset]\n");
                 printf("\t'-y'\t--min-block-density\tSet minimum block density. [Default: 0.5]\n");
                 printf("\t'-x'\t--edit-distance\tSet edit distance for pattern matching (0-2). [Default: 1]\n");
+                printf("\t\t--indels\tAllow insertions and deletions within the -x edit distance, not only substitutions. [Default: false]\n");
+                printf("\t\t--periodic-scan\tOnly match motifs inside tandem-repeat stretches with the canonical period; isolated matches are skipped. [Default: false]\n");
 
                 printf("\nOptional Parameters:\n");
                 printf("\t'-w'\t--window\tSet sliding window size. [Default: 1000]\n");
@@ -555,6 +622,9 @@ int main(int argc, char **argv) {
                 printf("\t\t--plot-report\tGenerate a PDF plot report after analysis (requires Python 3 + matplotlib). [Default: false]\n");
                 printf("\t\t--fastq-subset\tStream FASTQ reads with Teloscope-valid telomeric blocks to stdout, or save to a file with -o. [Default: false]\n");
                 printf("\t\t--bam-subset\tStream BAM records with Teloscope-valid telomeric blocks to stdout, or save to a file with -o. [Default: false]\n");
+                printf("\t\t--window-levels\tAlso write -r/-g/-e tracks for these coarser non-overlapping window sizes, separated by commas, from the same scan. Each must be a multiple of -s. [Default: unset]\n");
+                printf("\t\t--max-memory\tBound the window metrics and matches held for the report to this many GB; paths over it spill to a scratch file in the output directory. [Default: unset (unbounded)]\n");
+                printf("\t\t--kernel\tForce the vector kernels: auto, scalar, sse2, avx2, avx512. [Default: auto (best supported by the CPU)]\n");
 
                 printf("\t'-v'\t--version\tPrint current software version.\n");
                 printf("\t'-h'\t--help\tPrint current software options.\n");
@@ -632,24 +702,95 @@ int main(int argc, char **argv) {
         userInput.rawPatterns = {userInput.canonicalFwd, userInput.canonicalRev};
     }
 
+    // match sizes share a 16-bit word with the edit distance and flags
+    for (const std::string &seed : userInput.rawPatterns) {
+        if (seed.size() + (userInput.indels ? userInput.editDistance : 0) > MatchStore::maxMatchSize) {
+            fprintf(stderr, "Error: Matches are limited to %u bp, pattern '%s' has %zu.\n",
+                    MatchStore::maxMatchSize, seed.c_str(), seed.size());
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // window levels are built from the step lattice; a window must hold
+    // the longest match, which can be longer than its seed with --indels
+    for (uint32_t level : userInput.windowLevels) {
+        if (level <= userInput.windowSize || level % userInput.step != 0) {
+            fprintf(stderr, "Error: Window level (%u) must be larger than the window size (%d) and a multiple of the step size (%d).\n",
+                    level, userInput.windowSize, userInput.step);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (!userInput.windowLevels.empty()) {
+        size_t longestMatch = 0;
+        for (const std::string &seed : userInput.rawPatterns) longestMatch = std::max(longestMatch, seed.size());
+        if (userInput.indels) longestMatch += userInput.editDistance;
+        if (userInput.windowSize < longestMatch) {
+            fprintf(stderr, "Error: --window-levels needs a window size (%u) of at least the longest match (%zu).\n",
+                    userInput.windowSize, longestMatch);
+            exit(EXIT_FAILURE);
+        }
+    }
+
     lg.verbose("Input variables assigned");
-    userInput.patternInfo = expandPatternsWithOrientation(
-        userInput.rawPatterns, userInput.editDistance, userInput.canonicalFwd);
+
+    // indels have no enumerated fallback: every seed must fit the bit-parallel matcher
+    if (userInput.indels) {
+        if (userInput.editDistance > ApproxMatcher::maxErrors) {
+            fprintf(stderr, "Error: --indels allows at most %u edits (-x %u).\n",
+                    ApproxMatcher::maxErrors, userInput.editDistance);
+            exit(EXIT_FAILURE);
+        }
+        for (const std::string &seed : userInput.rawPatterns) {
+            if (seed.size() > ApproxMatcher::maxSeedLength) {
+                fprintf(stderr, "Error: --indels supports patterns of up to %u bp, '%s' has %zu.\n",
+                        ApproxMatcher::maxSeedLength, seed.c_str(), seed.size());
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    // IUPAC codes stay character classes in the bit-parallel matcher whenever the
+    // seeds fit it, rather than multiplying into the variant list. Literal seeds
+    // are enumerated for the automaton when it is estimated to be the cheaper scan
+    bool seedsFit = std::all_of(userInput.rawPatterns.begin(), userInput.rawPatterns.end(),
+        [](const std::string &seed) { return seed.size() <= ApproxMatcher::maxSeedLength; });
+    bool enumerate = !seedsFit ||
+        (!userInput.indels && !hasDegenerateSeeds(userInput.rawPatterns) &&
+         !ApproxMatcher::cheaperThanAutomaton(
+             ApproxMatcher::countWords(getSeedsWithOrientation(userInput.rawPatterns, userInput.canonicalFwd)),
+             userInput.editDistance,
+             countAutomatonStates(userInput.rawPatterns, userInput.editDistance)));
+
+    userInput.patternInfo.clear();
+    if (enumerate) {
+        userInput.patternInfo = expandPatternsWithOrientation(
+            userInput.rawPatterns, userInput.editDistance, userInput.canonicalFwd);
+    }
     
     userInput.patterns.clear();
-    userInput.patterns.reserve(userInput.patternInfo.size());
-    for (const auto& [pattern, isForward] : userInput.patternInfo) {
+    for (const auto& [pattern, isForward] : enumerate ? userInput.patternInfo
+             : getSeedsWithOrientation(userInput.rawPatterns, userInput.canonicalFwd)) {
         userInput.patterns.push_back(pattern);
     }
 
-    fprintf(stderr, "Scanning %zu telomeric variants (includes reverse complements).\n",
-            userInput.patterns.size());
-    if (userInput.editDistance > 0) {
+    if (enumerate) {
+        fprintf(stderr, "Scanning %zu telomeric variants (includes reverse complements).\n",
+                userInput.patterns.size());
+    } else {
+        fprintf(stderr, "Scanning %zu seeds (includes reverse complements) with the bit-parallel matcher; variants are not enumerated.\n",
+                userInput.patterns.size());
+    }
+    fprintf(stderr, "Using %s kernels.\n", kernels::active().name);
+    if (userInput.editDistance > 0 && userInput.indels) {
+        fprintf(stderr, "Edit distance enabled: up to %u edit%s (substitutions and indels) per seed.\n",
+                userInput.editDistance,
+                userInput.editDistance > 1 ? "s" : "");
+    } else if (userInput.editDistance > 0) {
         fprintf(stderr, "Edit distance enabled: up to %u substitution%s per seed.\n",
                 userInput.editDistance,
                 userInput.editDistance > 1 ? "s" : "");
     }
-    if (userInput.patterns.size() > 500) {
+    if (enumerate && userInput.patterns.size() > 500) {
         fprintf(stderr, "Warning: %zu patterns is unusually high and may be slow on large genomes.\n",
                 userInput.patterns.size());
         fprintf(stderr, "  Consider fewer IUPAC wildcards or a lower -x value.\n");
@@ -0,0 +1,112 @@
+#include "match-store.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <tuple>
+
+uint32_t MatchStore::intern(const std::string &sequence) {
+    auto it = sequenceIndex.find(sequence);
+    if (it != sequenceIndex.end()) return it->second;
+    const uint32_t id = static_cast<uint32_t>(sequences.size());
+    sequences.push_back(sequence);
+    sequenceIndex.emplace(sequence, id);
+    return id;
+}
+
+void MatchStore::push_back(const MatchInfo &match, const char *seq) {
+    // sequence is read soft-masked, record the bases uppercase
+    lookupKey.assign(seq, match.matchSize);
+    for (char &base : lookupKey) base = static_cast<char>(std::toupper(static_cast<unsigned char>(base)));
+    sequenceIds.resize(size(), 0); // ids stay aligned if earlier matches had none
+    push_back(match);
+    sequenceIds.push_back(intern(lookupKey));
+}
+
+size_t MatchStore::lowerBound(uint64_t position) const {
+    size_t lo = 0, hi = size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (this->position(mid) < position) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void MatchStore::sortFrom(size_t from) {
+    if (from >= size()) return;
+    const bool hasSequences = sequenceIds.size() == size();
+    std::vector<std::pair<MatchInfo, uint32_t>> tail;
+    tail.reserve(size() - from);
+    for (size_t i = from; i < size(); ++i) tail.emplace_back((*this)[i], hasSequences ? sequenceIds[i] : 0);
+    std::stable_sort(tail.begin(), tail.end(), [](const auto &a, const auto &b) {
+        return std::tie(a.first.position, a.first.matchSize) < std::tie(b.first.position, b.first.matchSize);
+    });
+
+    offsets.resize(from);
+    sizeFlags.resize(from);
+    if (hasSequences) sequenceIds.resize(from);
+    while (!runs.empty() && runs.back().first >= from) runs.pop_back();
+    for (const auto &[match, id] : tail) {
+        push_back(match);
+        if (hasSequences) sequenceIds.push_back(id);
+    }
+}
+
+void MatchStore::append(const View &view) {
+    const MatchStore &other = view.getStore();
+    const bool hasSequences = !other.sequenceIds.empty();
+    std::vector<uint32_t> ids;
+    if (hasSequences) {
+        sequenceIds.resize(size(), 0);
+        ids.reserve(other.sequences.size());
+        for (const std::string &sequence : other.sequences) ids.push_back(intern(sequence));
+    }
+    for (size_t i = view.first(); i != npos; i = view.next(i + 1)) {
+        pushPosition(other.position(i));
+        sizeFlags.push_back(other.sizeFlags[i]);
+        if (hasSequences) sequenceIds.push_back(i < other.sequenceIds.size() ? ids[other.sequenceIds[i]] : 0);
+    }
+}
+
+size_t MatchStore::memoryUsage() const {
+    size_t bytes = offsets.capacity() * sizeof(uint32_t) + sizeFlags.capacity() * sizeof(uint16_t) +
+                   sequenceIds.capacity() * sizeof(uint32_t) + runs.capacity() * sizeof(Run);
+    for (const std::string &sequence : sequences) bytes += 2 * (sizeof(std::string) + sequence.capacity());
+    return bytes;
+}
+
+void MatchStore::serialize(std::string &out) const {
+    const bool hasSequences = !sequenceIds.empty();
+    out.push_back(hasSequences ? 1 : 0);
+    for (size_t i = 0; i < size(); ++i) {
+        const uint64_t pos = position(i);
+        out.append(reinterpret_cast<const char *>(&pos), sizeof(pos));
+        out.append(reinterpret_cast<const char *>(&sizeFlags[i]), sizeof(uint16_t));
+        if (!hasSequences) continue;
+        const uint16_t length = sizeFlags[i] & sizeMask;
+        if (i < sequenceIds.size()) out.append(sequences[sequenceIds[i]], 0, length);
+        else out.append(length, 'N');
+    }
+}
+
+void MatchStore::deserialize(const char *data, size_t bytes) {
+    if (bytes == 0) return;
+    const char *end = data + bytes;
+    const bool hasSequences = *data++ != 0;
+    if (hasSequences) sequenceIds.resize(size(), 0);
+    while (data < end) {
+        uint64_t pos;
+        uint16_t word;
+        std::memcpy(&pos, data, sizeof(pos));
+        std::memcpy(&word, data + sizeof(pos), sizeof(word));
+        data += sizeof(pos) + sizeof(word);
+        pushPosition(pos);
+        sizeFlags.push_back(word);
+        if (!hasSequences) continue;
+        const uint16_t length = word & sizeMask;
+        lookupKey.assign(data, length);
+        data += length;
+        sequenceIds.push_back(intern(lookupKey));
+    }
+}
@@ -0,0 +1,105 @@
+#include "prefilter.h"
+
+#include <cmath>
+#include <map>
+
+#include "kernels.h"
+
+namespace {
+
+constexpr uint8_t minAnchorLen = 3;
+constexpr double maxRelativeCost = 0.5; // prefilter must at least halve the exact scan work
+constexpr double exactOpsPerBase = 4.0; // automaton step: load, lookup, output check
+
+bool isAcgt(char c) {
+    return c == 'A' || c == 'C' || c == 'G' || c == 'T';
+}
+
+// Greedy hitting set: q-grams such that every pattern contains at least one.
+std::vector<std::string> getAnchorSet(const std::vector<std::string> &patterns, uint8_t q) {
+    std::vector<std::string> anchorSet;
+    std::vector<const std::string *> remaining;
+    remaining.reserve(patterns.size());
+    for (const std::string &pattern : patterns) remaining.push_back(&pattern);
+
+    while (!remaining.empty()) {
+        if (anchorSet.size() == MotifPrefilter::maxAnchors) return {};
+
+        std::map<std::string, size_t> counts;
+        for (const std::string *pattern : remaining) {
+            std::map<std::string, bool> seen;
+            for (size_t i = 0; i + q <= pattern->size(); ++i) {
+                std::string gram = pattern->substr(i, q);
+                if (!seen[gram]) {
+                    seen[gram] = true;
+                    counts[gram]++;
+                }
+            }
+        }
+
+        auto best = counts.begin();
+        for (auto it = counts.begin(); it != counts.end(); ++it) {
+            if (it->second > best->second) best = it;
+        }
+        const std::string anchor = best->first;
+        anchorSet.push_back(anchor);
+
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+            [&](const std::string *pattern) { return pattern->find(anchor) != std::string::npos; }),
+            remaining.end());
+    }
+    return anchorSet;
+}
+
+} // namespace
+
+bool MotifPrefilter::build(const std::vector<std::pair<std::string, bool>> &patternInfo) {
+    anchors.clear();
+    anchorLen = 0;
+    longestPattern = 0;
+
+    std::vector<std::string> patterns;
+    size_t shortest = SIZE_MAX;
+    for (const auto &[pattern, isForward] : patternInfo) {
+        if (pattern.empty() || !std::all_of(pattern.begin(), pattern.end(), isAcgt)) return false;
+        patterns.push_back(pattern);
+        shortest = std::min(shortest, pattern.size());
+        longestPattern = static_cast<uint16_t>(std::max<size_t>(longestPattern, pattern.size()));
+    }
+    if (patterns.empty() || shortest < minAnchorLen) return false;
+
+    // cost per base relative to the exact scan: SIMD compares plus the expected
+    // fraction of bases still covered by candidate spans on uniform sequence
+    double bestCost = maxRelativeCost;
+    std::vector<std::string> bestSet;
+    const double vectorWidth = kernels::active().vectorWidth;
+    const uint8_t maxLen = static_cast<uint8_t>(std::min<size_t>(maxAnchorLen, shortest));
+    for (uint8_t q = minAnchorLen; q <= maxLen; ++q) {
+        std::vector<std::string> anchorSet = getAnchorSet(patterns, q);
+        if (anchorSet.empty()) continue;
+
+        double rate = anchorSet.size() / std::pow(4.0, q);
+        double covered = 1.0 - std::exp(-rate * (2.0 * longestPattern - q));
+        double compares = q * (anchorSet.size() + 1) / vectorWidth;
+        double cost = compares / exactOpsPerBase + covered;
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestSet = anchorSet;
+        }
+    }
+    if (bestSet.empty()) return false;
+
+    anchors.assign(bestSet.size() * maxAnchorLen, 0);
+    for (size_t a = 0; a < bestSet.size(); ++a) {
+        // lowercase, findAnchor folds the sequence side
+        std::transform(bestSet[a].begin(), bestSet[a].end(), anchors.begin() + a * maxAnchorLen,
+                       [](char c) { return static_cast<char>(c | 0x20); });
+    }
+    anchorLen = static_cast<uint8_t>(bestSet.front().size());
+    return true;
+}
+
+uint64_t MotifPrefilter::nextAnchor(const char *seq, uint64_t pos, uint64_t end) const {
+    return kernels::active().findAnchor(seq, pos, end, anchors.data(),
+                                        static_cast<uint32_t>(anchors.size() / maxAnchorLen), anchorLen);
+}
@@ -16,6 +16,8 @@ UserInputTeloscope makeReadFilterInput(const UserInputTeloscope &input) {
     // max/2 keeps the full read terminal without overflowing scanSegment's doubled limit.
     readInput.terminalLimit = std::numeric_limits<uint32_t>::max() / 2;
     readInput.ultraFastMode = true;
+    readInput.adaptiveExtent = 0; // reads are scanned whole
+    readInput.periodicScan = false; // short arrays fall below the 64 bp periodicity blocks
     readInput.outFasta = false;
     readInput.outWinRepeats = false;
     readInput.outGC = false;
@@ -34,12 +36,12 @@ ReadTelomereFilter::ReadTelomereFilter(const UserInputTeloscope &input)
 
 ReadTelomereFilter::~ReadTelomereFilter() = default;
 
-bool ReadTelomereFilter::matches(std::string sequence) {
+bool ReadTelomereFilter::matches(std::string_view sequence) {
     if (!sequence.empty() && sequence.back() == '\r') {
-        sequence.pop_back();
+        sequence.remove_suffix(1);
     }
-    unmaskSequence(sequence);
 
-    SegmentData segmentData = teloscope->scanSegment(sequence, 0, true);
+    thread_local SegmentData segmentData; // reused across the reads of a worker
+    teloscope->scanSegment(sequence, 0, true, segmentData);
     return !segmentData.terminalBlocks.empty();
 }
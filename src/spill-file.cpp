@@ -0,0 +1,50 @@
+#include "spill-file.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+void SpillFile::open() {
+    file.open(path, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file.is_open()) {
+        fprintf(stderr, "Error: Could not open '%s' for writing.\n", path.c_str());
+        exit(EXIT_FAILURE);
+    }
+    std::error_code removeError;
+    unlinked = std::filesystem::remove(path, removeError); // not where open files cannot be unlinked
+}
+
+SpillFile::~SpillFile() {
+    if (!file.is_open()) return;
+    file.close();
+    if (unlinked) return;
+    std::error_code removeError;
+    std::filesystem::remove(path, removeError);
+}
+
+SpillFile::Extent SpillFile::append(const char *data, uint64_t size) {
+    std::lock_guard<std::mutex> lck(mtx);
+    if (!file.is_open()) open();
+
+    Extent extent{bytes, size};
+    file.seekp(static_cast<std::streamoff>(bytes));
+    file.write(data, static_cast<std::streamsize>(size));
+    if (!file) {
+        fprintf(stderr, "Error: Could not write to the spill file '%s'.\n", path.c_str());
+        exit(EXIT_FAILURE);
+    }
+    bytes += size;
+    return extent;
+}
+
+void SpillFile::read(const Extent &extent, char *data) {
+    if (extent.bytes == 0) return;
+    std::lock_guard<std::mutex> lck(mtx);
+
+    file.seekg(static_cast<std::streamoff>(extent.offset));
+    file.read(data, static_cast<std::streamsize>(extent.bytes));
+    if (!file) {
+        fprintf(stderr, "Error: Could not read back from the spill file '%s'.\n", path.c_str());
+        exit(EXIT_FAILURE);
+    }
+}
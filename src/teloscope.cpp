@@ -8,6 +8,12 @@
 #include <cmath>
 #include <type_traits>
 #include <chrono>
+#include <cstdio>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
 
 #include "log.h"
 #include "global.h"
@@ -23,110 +29,188 @@
 #include "input-filters.h"
 #include "input-gfa.h"
 #include "teloscope.h"
+#include "kernels.h"
 #include "input.h"
 
+namespace {
+
+// Runs task(0) to task(count - 1) on the calling thread and on pool workers
+// as they become idle, and hands each finished task to join(i) on the calling
+// thread, in order. At most `inFlight` tasks are started and not yet joined,
+// so their results never pile up. A worker takes tasks while the bound allows
+// and then returns to the pool rather than waiting on it; the caller joins,
+// queues workers again as the bound frees up, and takes tasks itself instead
+// of waiting for the pool, so a pool job can split its work this way. A
+// worker starting after the last task was taken returns at once without
+// touching the task.
+void runOnIdleWorkers(size_t count, size_t inFlight, const std::function<void(size_t)>& task,
+                      const std::function<void(size_t)>& join) {
+    struct Tasks {
+        std::mutex mutex;
+        std::condition_variable finishedOne;
+        size_t next = 0, joined = 0, count = 0, inFlight = 0, helpers = 0;
+        std::vector<bool> finished;
+        const std::function<void(size_t)>* task = nullptr;
+
+        bool canStart() const { return next < count && next < joined + inFlight; }
+
+        // runs the next task with the lock released
+        void runNext(std::unique_lock<std::mutex>& lock) {
+            const size_t i = next++;
+            lock.unlock();
+            (*task)(i);
+            lock.lock();
+            finished[i] = true;
+            finishedOne.notify_all();
+        }
+    };
+    auto tasks = std::make_shared<Tasks>();
+    tasks->count = count;
+    tasks->inFlight = std::max<size_t>(inFlight, 1);
+    tasks->finished.assign(count, false);
+    tasks->task = &task;
+
+    const size_t maxHelpers = std::min<size_t>(count, threadPool.totalThreads()) - 1;
+    auto queueHelpers = [&](std::unique_lock<std::mutex>& lock) {
+        size_t queued = 0;
+        while (tasks->helpers < maxHelpers && tasks->next + tasks->helpers < tasks->joined + tasks->inFlight &&
+               tasks->next + tasks->helpers < count) {
+            tasks->helpers++;
+            queued++;
+        }
+        if (queued == 0) return;
+        lock.unlock();
+        for (size_t i = 0; i < queued; ++i) {
+            threadPool.queueJob([tasks]() {
+                std::unique_lock<std::mutex> lock(tasks->mutex);
+                while (tasks->canStart()) tasks->runNext(lock);
+                tasks->helpers--;
+                return true;
+            });
+        }
+        lock.lock();
+    };
 
-uint64_t Teloscope::getTerminalBlocks(
-    const std::vector<MatchInfo>& matches,
-    std::vector<TelomereBlock>& outBlocks,
-    uint64_t segmentSize, uint64_t absPos, bool fromStart) {
+    std::unique_lock<std::mutex> lock(tasks->mutex);
+    queueHelpers(lock);
+    while (tasks->joined < count) {
+        const size_t i = tasks->joined;
+        if (tasks->finished[i]) {
+            lock.unlock();
+            join(i);
+            lock.lock();
+            tasks->joined++;
+            queueHelpers(lock);
+        } else if (tasks->canStart()) {
+            tasks->runNext(lock);
+        } else {
+            tasks->finishedOne.wait(lock);
+        }
+    }
+}
 
-    uint64_t boundary = fromStart ? absPos : (absPos + segmentSize);
-    int64_t n = static_cast<int64_t>(matches.size());
+} // namespace
 
-    uint32_t terminalLimit = userInput.terminalLimit;
-    uint16_t matchDist = userInput.maxMatchDist;
-    uint16_t blockDist = userInput.maxBlockDist;
-    uint16_t minBlockCounts = userInput.minBlockCounts;
-    uint16_t minBlockLen = userInput.minBlockLen;
-    float minBlockDensity = userInput.minBlockDensity;
-
-    int64_t startIdx = fromStart ? 0 : n - 1;
-    int64_t endIdx   = fromStart ? n : -1;
-    int64_t step     = fromStart ? 1 : -1;
-
-    auto inZone = [&](uint64_t pos) -> bool {
-        uint64_t rel = pos - absPos;
-        if (segmentSize <= terminalLimit) return true;
-        return fromStart ? (rel < terminalLimit) : (rel >= segmentSize - terminalLimit);
-    };
 
-    // Phase 1: directional scan for sub-blocks
-    std::vector<TelomereBlock> subBlocks;
-
-    bool inBlock = false;
-    uint64_t blockStart = 0, blockEnd = 0, prevPosition = 0;
-    uint32_t blockCounts = 0, forwardCount = 0, canonicalCount = 0;
-    uint32_t totalCovered = 0, fwdCovered = 0, canCovered = 0;
-
-    auto startNewBlock = [&](const MatchInfo& m) {
-        blockStart = m.position;
-        blockEnd = m.position + m.matchSize;
-        prevPosition = m.position;
-        blockCounts = 1;
-        forwardCount = m.isForward;
-        canonicalCount = m.isCanonical;
-        totalCovered = m.matchSize;
-        fwdCovered = m.isForward * m.matchSize;
-        canCovered = m.isCanonical * m.matchSize;
-        inBlock = true;
-    };
+void Teloscope::BlockBuilder::Chain::begin(const MatchInfo& m) {
+    start = m.position;
+    end = m.position + m.matchSize;
+    prevPosition = m.position;
+    counts = 1;
+    forwardCount = m.isForward;
+    canonicalCount = m.isCanonical;
+    totalCovered = m.matchSize;
+    fwdCovered = m.isForward * m.matchSize;
+    canCovered = m.isCanonical * m.matchSize;
+    open = true;
+}
 
-    auto finalizeSubBlock = [&]() {
-        if (blockCounts >= minBlockCounts && canonicalCount > 0 &&
-            canCovered >= minBlockDensity * (blockEnd - blockStart)) {
-            TelomereBlock block;
-            block.start = blockStart;
-            block.blockLen = static_cast<uint32_t>(blockEnd - blockStart);
-            block.blockCounts = blockCounts;
-            block.forwardCount = forwardCount;
-            block.reverseCount = blockCounts - forwardCount;
-            block.canonicalCount = canonicalCount;
-            block.nonCanonicalCount = blockCounts - canonicalCount;
-            block.totalCovered = totalCovered;
-            block.fwdCovered = fwdCovered;
-            block.canCovered = canCovered;
-            subBlocks.push_back(block);
-        }
-        inBlock = false;
-    };
+void Teloscope::BlockBuilder::Chain::extend(const MatchInfo& m) {
+    end = m.position + m.matchSize;
+    prevPosition = m.position;
+    counts++;
+    forwardCount += m.isForward;
+    canonicalCount += m.isCanonical;
+    totalCovered += m.matchSize;
+    fwdCovered += m.isForward * m.matchSize;
+    canCovered += m.isCanonical * m.matchSize;
+}
 
-    for (int64_t idx = startIdx; idx != endIdx; idx += step) {
-        const MatchInfo& m = matches[idx];
+TelomereBlock Teloscope::BlockBuilder::Chain::toBlock() const {
+    TelomereBlock block;
+    block.start = start;
+    block.blockLen = static_cast<uint32_t>(end - start);
+    block.blockCounts = counts;
+    block.forwardCount = forwardCount;
+    block.reverseCount = counts - forwardCount;
+    block.canonicalCount = canonicalCount;
+    block.nonCanonicalCount = counts - canonicalCount;
+    block.totalCovered = totalCovered;
+    block.fwdCovered = fwdCovered;
+    block.canCovered = canCovered;
+    return block;
+}
 
-        if (!inBlock) {
-            if (inZone(m.position)) {
-                startNewBlock(m);
-            } else {
-                break;
-            }
-        } else {
-            uint64_t gap = fromStart ? (m.position - prevPosition) : (prevPosition - m.position);
-            if (gap <= matchDist) {
-                if (fromStart) blockEnd = m.position + m.matchSize;
-                else blockStart = m.position;
-                blockCounts++;
-                forwardCount += m.isForward;
-                canonicalCount += m.isCanonical;
-                totalCovered += m.matchSize;
-                fwdCovered += m.isForward * m.matchSize;
-                canCovered += m.isCanonical * m.matchSize;
-                prevPosition = m.position;
-            } else {
-                finalizeSubBlock();
-                if (inZone(m.position)) {
-                    startNewBlock(m);
-                } else {
-                    break;
-                }
-            }
-        }
+bool Teloscope::BlockBuilder::Chain::accepts(const MatchInfo& m, uint16_t maxGap) const {
+    return open && m.position - prevPosition <= maxGap;
+}
+
+
+void Teloscope::BlockBuilder::reset(const UserInputTeloscope& userInput, uint64_t segmentSize,
+                                    uint64_t absPos, bool interstitial) {
+    this->segmentSize = segmentSize;
+    this->absPos = absPos;
+    this->interstitial = interstitial;
+    terminalLimit = userInput.terminalLimit;
+    matchDist = userInput.maxMatchDist;
+    blockDist = userInput.maxBlockDist;
+    minBlockCounts = userInput.minBlockCounts;
+    minBlockLen = userInput.minBlockLen;
+    minBlockDensity = userInput.minBlockDensity;
+    minInterstitialLen = static_cast<uint16_t>(2 * userInput.patterns.front().size());
+    fwdBoundary = absPos;
+    revBoundary = absPos + segmentSize;
+    qZoneStart = segmentSize > terminalLimit ? absPos + segmentSize - terminalLimit : absPos;
+
+    fwdChain = Chain();
+    revChain = Chain();
+    itsChain = Chain();
+    pSubBlocks.clear();
+    qSubBlocks.clear();
+    terminalBlocks.clear();
+    interstitialBlocks.clear();
+    pDone = false;
+    head.clear();
+    pending.clear();
+    deferred = false;
+}
+
+bool Teloscope::BlockBuilder::inPZone(uint64_t position) const {
+    return segmentSize <= terminalLimit || position - absPos < terminalLimit;
+}
+
+void Teloscope::BlockBuilder::closeSubBlock(const Chain& chain, std::vector<TelomereBlock>& subBlocks) const {
+    if (chain.counts >= minBlockCounts && chain.canonicalCount > 0 &&
+        chain.canCovered >= minBlockDensity * (chain.end - chain.start)) {
+        subBlocks.push_back(chain.toBlock());
+    }
+}
+
+void Teloscope::BlockBuilder::closeInterstitial(const Chain& chain) {
+    TelomereBlock block = chain.toBlock();
+    block.blockLabel = computeBlockLabel(block.forwardCount, block.blockCounts);
+
+    if (block.blockLen >= minInterstitialLen && block.canonicalCount >= minInterstitialCanonical &&
+        !(block.blockLabel == 'b' && block.forwardCount < 2 && block.reverseCount < 2)) {
+        interstitialBlocks.push_back(block);
     }
+}
 
-    if (inBlock) finalizeSubBlock();
+uint64_t Teloscope::BlockBuilder::mergeSubBlocks(const std::vector<TelomereBlock>& subBlocks, bool fromStart) {
+    uint64_t boundary = fromStart ? absPos : (absPos + segmentSize);
     if (subBlocks.empty()) return boundary;
 
-    // Phase 2: merge sub-blocks within blockDist
+    // merge sub-blocks, ordered from the sequence end inward, within blockDist
     TelomereBlock current = subBlocks[0];
 
     auto finalizeExtended = [&]() {
@@ -139,13 +223,13 @@ uint64_t Teloscope::getTerminalBlocks(
             uint64_t rightDist = (relEnd <= segmentSize) ? (segmentSize - relEnd) : 0;
             current.hasValidOr = fromStart ? (leftDist <= rightDist) : (leftDist >= rightDist);
 
-            outBlocks.push_back(current);
+            terminalBlocks.push_back(current);
             boundary = fromStart ? (current.start + current.blockLen) : current.start;
         }
     };
 
     for (size_t i = 1; i < subBlocks.size(); ++i) {
-        TelomereBlock& next = subBlocks[i];
+        const TelomereBlock& next = subBlocks[i];
         uint64_t gap = fromStart
             ? (next.start - (current.start + current.blockLen))
             : (current.start - (next.start + next.blockLen));
@@ -175,84 +259,115 @@ uint64_t Teloscope::getTerminalBlocks(
     return boundary;
 }
 
+void Teloscope::BlockBuilder::finishP() {
+    if (fwdChain.open) closeSubBlock(fwdChain, pSubBlocks);
+    fwdChain.open = false;
+    fwdBoundary = mergeSubBlocks(pSubBlocks, true);
+    pSubBlocks.clear();
+    pDone = true;
 
-void Teloscope::getInterstitialBlocks(
-    const std::vector<MatchInfo>& allMatches,
-    std::vector<TelomereBlock>& outBlocks,
-    uint64_t fwdBoundary, uint64_t revBoundary) {
-
-    uint16_t mergeDist = userInput.maxMatchDist;
-    uint16_t minLength = 2 * userInput.patterns.front().size();
-    constexpr uint16_t minCanonicalCount = 4;
-
-    auto it = std::lower_bound(allMatches.begin(), allMatches.end(), fwdBoundary,
-        [](const MatchInfo& m, uint64_t val) { return m.position < val; });
-
-    if (it == allMatches.end() || it->position >= revBoundary) return;
-
-    bool inBlock = false;
-    uint64_t blockStart = 0, blockEnd = 0, prevPosition = 0;
-    uint32_t blockCounts = 0, forwardCount = 0, canonicalCount = 0;
-    uint32_t totalCovered = 0, fwdCovered = 0, canCovered = 0;
-
-    auto startNewBlock = [&](const MatchInfo& m) {
-        blockStart = m.position;
-        blockEnd = m.position + m.matchSize;
-        prevPosition = m.position;
-        blockCounts = 1;
-        forwardCount = m.isForward;
-        canonicalCount = m.isCanonical;
-        totalCovered = m.matchSize;
-        fwdCovered = m.isForward * m.matchSize;
-        canCovered = m.isCanonical * m.matchSize;
-        inBlock = true;
-    };
+    // interstitial blocks start at the first match past the p telomere
+    if (interstitial) {
+        for (size_t i = head.lowerBound(fwdBoundary); i < head.size(); ++i) addInterstitial(head[i]);
+    }
+    head.clear();
+}
 
-    auto finalizeBlock = [&]() {
-        uint32_t blockLen = static_cast<uint32_t>(blockEnd - blockStart);
-        char label = computeBlockLabel(forwardCount, blockCounts);
-
-        if (blockLen >= minLength && canonicalCount >= minCanonicalCount &&
-            !(label == 'b' && forwardCount < 2 && (blockCounts - forwardCount) < 2)) {
-
-            TelomereBlock block;
-            block.start = blockStart;
-            block.blockLen = blockLen;
-            block.blockCounts = blockCounts;
-            block.forwardCount = forwardCount;
-            block.reverseCount = blockCounts - forwardCount;
-            block.canonicalCount = canonicalCount;
-            block.nonCanonicalCount = blockCounts - canonicalCount;
-            block.totalCovered = totalCovered;
-            block.fwdCovered = fwdCovered;
-            block.canCovered = canCovered;
-            block.blockLabel = label;
-            outBlocks.push_back(block);
+void Teloscope::BlockBuilder::addInterstitial(const MatchInfo& m) {
+    if (deferred) {
+        pending.push_back(m);
+        return;
+    }
+    const bool extends = itsChain.accepts(m, matchDist);
+    if (!extends && itsChain.open) {
+        closeInterstitial(itsChain);
+        itsChain.open = false;
+        pending.clear();
+    }
+    // from the q zone on, the q telomere may still cut the block: keep its matches
+    if (m.position >= qZoneStart) {
+        deferred = true;
+        itsChain.open = false;
+    } else if (extends) {
+        itsChain.extend(m);
+    } else {
+        itsChain.begin(m);
+    }
+    pending.push_back(m);
+}
+
+void Teloscope::BlockBuilder::add(const MatchInfo& m) {
+    // p telomere: forward chains starting in the p zone, walked outward in
+    if (!pDone) {
+        bool pClosed = false;
+        if (m.isForward) {
+            if (fwdChain.accepts(m, matchDist)) {
+                fwdChain.extend(m);
+            } else {
+                if (fwdChain.open) closeSubBlock(fwdChain, pSubBlocks);
+                fwdChain.open = false;
+                if (inPZone(m.position)) fwdChain.begin(m);
+                else pClosed = true;
+            }
         }
-        inBlock = false;
-    };
+        if (interstitial) head.push_back(m);
+        // no later forward match can start or extend a p chain
+        if (pClosed || (!inPZone(m.position) && (!fwdChain.open || m.position - fwdChain.prevPosition > matchDist))) {
+            finishP();
+        }
+    } else if (interstitial) {
+        addInterstitial(m);
+    }
 
-    for (; it != allMatches.end() && it->position < revBoundary; ++it) {
-        const MatchInfo& m = *it;
-
-        if (!inBlock) {
-            startNewBlock(m);
-        } else if (m.position - prevPosition <= mergeDist) {
-            blockEnd = m.position + m.matchSize;
-            blockCounts++;
-            forwardCount += m.isForward;
-            canonicalCount += m.isCanonical;
-            totalCovered += m.matchSize;
-            fwdCovered += m.isForward * m.matchSize;
-            canCovered += m.isCanonical * m.matchSize;
-            prevPosition = m.position;
+    // q telomere: reverse chains whose last match lies in the q zone
+    if (!m.isForward) {
+        if (revChain.accepts(m, matchDist)) {
+            revChain.extend(m);
         } else {
-            finalizeBlock();
-            startNewBlock(m);
+            if (revChain.open && revChain.prevPosition >= qZoneStart) closeSubBlock(revChain, qSubBlocks);
+            revChain.begin(m);
+        }
+    }
+}
+
+void Teloscope::BlockBuilder::finish(std::vector<TelomereBlock>& outTerminal, std::vector<TelomereBlock>& outInterstitial) {
+    if (!pDone) finishP();
+
+    if (revChain.open && revChain.prevPosition >= qZoneStart) closeSubBlock(revChain, qSubBlocks);
+    revChain.open = false;
+    std::reverse(qSubBlocks.begin(), qSubBlocks.end()); // merged from the q end inward
+    revBoundary = mergeSubBlocks(qSubBlocks, false);
+
+    if (interstitial) {
+        if (deferred) {
+            Chain chain;
+            for (size_t i = 0; i < pending.size(); ++i) {
+                const MatchInfo m = pending[i];
+                if (m.position >= revBoundary) break;
+                if (chain.accepts(m, matchDist)) {
+                    chain.extend(m);
+                } else {
+                    if (chain.open) closeInterstitial(chain);
+                    chain.begin(m);
+                }
+            }
+            if (chain.open) closeInterstitial(chain);
+        } else if (itsChain.open) {
+            closeInterstitial(itsChain);
         }
+        if (fwdBoundary >= revBoundary) interstitialBlocks.clear();
     }
 
-    if (inBlock) finalizeBlock();
+    outTerminal.insert(outTerminal.end(), terminalBlocks.begin(), terminalBlocks.end());
+    outInterstitial.insert(outInterstitial.end(), interstitialBlocks.begin(), interstitialBlocks.end());
+}
+
+
+void Teloscope::reportAutomatonLayout() const {
+    char layout[160];
+    snprintf(layout, sizeof(layout), "Motif automaton: %zu states, %zu bytes per state, %zu-byte table aligned to %zu bytes",
+             trie.getStateCount(), trie.getBytesPerState(), trie.getTableBytes(), trie.getTableAlignment());
+    lg.verbose(layout);
 }
 
 
@@ -386,10 +501,11 @@ void Teloscope::labelTerminalBlocks(
 
 void Teloscope::analyzeWindow(const std::string_view &window, uint64_t windowStart,
                             WindowData& windowData, WindowData& nextOverlapData,
-                            SegmentData& segmentData, uint64_t segmentSize, uint64_t absPos) {
+                            SegmentData& segmentData, BlockBuilder& blocks,
+                            uint64_t segmentSize, uint64_t absPos) {
 
     windowData.windowStart = windowStart;
-    unsigned short int longestPatternSize = this->trie.getLongestPatternSize();
+    unsigned short int longestPatternSize = getLongestMatchSize();
     uint32_t step = userInput.step;
     uint32_t overlapSize = userInput.windowSize - step;
     uint32_t terminalLimit = userInput.terminalLimit;
@@ -414,193 +530,496 @@ void Teloscope::analyzeWindow(const std::string_view &window, uint64_t windowSta
                             ? 0
                             : std::min(step - longestPatternSize, overlapSize - longestPatternSize);
 
-    for (uint32_t i = startIndex; i < window.size(); ++i) {
-        if (computeGC || computeEntropy) {
-            char nucleotide = window[i];
-            uint8_t index;
-            switch (nucleotide) {
-                case 'A': index = 0; break;
-                case 'C': index = 1; break;
-                case 'G': index = 2; break;
-                case 'T': index = 3; break;
-                default: continue;
+    if (computeGC || computeEntropy) {
+        const auto &countBases = kernels::active().countBases;
+        uint32_t mainStart = alwaysMainWindow ? startIndex : std::max(startIndex, overlapSize);
+        if (mainStart < window.size()) {
+            countBases(window.data() + mainStart, window.size() - mainStart, windowData.nucleotideCounts);
+        }
+        uint32_t nextStart = std::max(startIndex, step);
+        if (hasOverlap && nextStart < window.size()) {
+            countBases(window.data() + nextStart, window.size() - nextStart, nextOverlapData.nucleotideCounts);
+        }
+    }
+
+    // one automaton pass, matches arrive ordered by start
+    scanMotifs(window.data(), startIndex, window.size(),
+               [&](uint64_t start, uint16_t matchLen, bool isForward, bool isCanonical, uint8_t distance) {
+        uint32_t i = static_cast<uint32_t>(start);
+        uint32_t j = i + matchLen - 1;
+        uint64_t matchPos = absPos + windowStart + i;
+
+        bool isTerminal;
+        if (windowFullyTerminal) {
+            isTerminal = true;
+        } else if (windowFullyInterstitial) {
+            isTerminal = false;
+        } else {
+            uint64_t absI = windowStart + i;
+            isTerminal = (absI <= terminalLimit || absI >= terminalEnd);
+        }
+
+        MatchInfo matchInfo;
+        matchInfo.position = matchPos;
+        matchInfo.isCanonical = isCanonical;
+        matchInfo.isForward = isForward;
+        matchInfo.matchSize = matchLen;
+        matchInfo.distance = distance;
+        matchInfo.isReported = isCanonical || isTerminal; // non-canonical -m output is terminal only
+
+        // Check dimers
+        if (isCanonical) {
+            if (hasLastCanonical && (matchPos - lastCanonicalPos) <= userInput.canonicalSize) {
+                if (!windowData.hasCanDimer && (alwaysMainWindow || j >= overlapSize)) {
+                    windowData.hasCanDimer = true;
+                }
+                if (!nextOverlapData.hasCanDimer && hasOverlap && i >= step) {
+                    nextOverlapData.hasCanDimer = true;
+                }
+            }
+            lastCanonicalPos = matchPos;
+            hasLastCanonical = true;
+        }
+
+        // Update windowData
+        if (alwaysMainWindow || j >= overlapSize) {
+            if (isCanonical) {
+                windowData.canonicalCounts++;
+                windowData.canonicalCovered += matchLen;
+                segmentData.canonicalCount++;
+            } else {
+                windowData.nonCanonicalCounts++;
+                windowData.nonCanonicalCovered += matchLen;
             }
 
-            if (alwaysMainWindow || i >= overlapSize) {
-                windowData.nucleotideCounts[index]++;
+            if (isForward) {
+                windowData.fwdCounts++;
+                windowData.fwdCovered += matchLen;
+            } else {
+                windowData.revCounts++;
+                windowData.revCovered += matchLen;
             }
-            if (hasOverlap && i >= step) {
-                nextOverlapData.nucleotideCounts[index]++;
+
+            blocks.add(matchInfo);
+            if (needMatchSeq && matchInfo.isReported) {
+                segmentData.matches.push_back(matchInfo, window.data() + i);
             }
         }
 
-        // trie pattern matching
-        int32_t current = trie.getRoot();
-        uint32_t scanLimit = std::min(i + longestPatternSize, static_cast<uint32_t>(window.size()));
-
-        for (uint32_t j = i; j < scanLimit; ++j) {
-            current = trie.getChild(current, window[j]);
-            if (current < 0) break;
-
-            if (trie.isEnd(current)) {
-                uint16_t matchLen = static_cast<uint16_t>(j - i + 1);
-                bool isForward = trie.isForward(current);
-                bool isCanonical = trie.isCanonical(current);
-                uint64_t matchPos = absPos + windowStart + i;
-
-                bool isTerminal;
-                if (windowFullyTerminal) {
-                    isTerminal = true;
-                } else if (windowFullyInterstitial) {
-                    isTerminal = false;
-                } else {
-                    uint64_t absI = windowStart + i;
-                    isTerminal = (absI <= terminalLimit || absI >= terminalEnd);
-                }
+        // Update nextOverlapData
+        if (hasOverlap && i >= step) {
+            if (isCanonical) {
+                nextOverlapData.canonicalCounts++;
+                nextOverlapData.canonicalCovered += matchLen;
+            } else {
+                nextOverlapData.nonCanonicalCounts++;
+                nextOverlapData.nonCanonicalCovered += matchLen;
+            }
 
-                MatchInfo matchInfo;
-                matchInfo.position = matchPos;
-                matchInfo.isCanonical = isCanonical;
-                matchInfo.isForward = isForward;
-                matchInfo.matchSize = matchLen;
-                if (needMatchSeq) {
-                    matchInfo.matchSeq = std::string(window.data() + i, matchLen);
-                }
+            // fwd/rev overlap metrics
+            if (isForward) {
+                nextOverlapData.fwdCounts++;
+                nextOverlapData.fwdCovered += matchLen;
+            } else {
+                nextOverlapData.revCounts++;
+                nextOverlapData.revCovered += matchLen;
+            }
+        }
+    });
+}
 
-                // Check dimers
-                if (isCanonical) {
-                    if (hasLastCanonical && (matchPos - lastCanonicalPos) <= userInput.canonicalSize) {
-                        if (!windowData.hasCanDimer && (alwaysMainWindow || j >= overlapSize)) {
-                            windowData.hasCanDimer = true;
-                        }
-                        if (!nextOverlapData.hasCanDimer && hasOverlap && i >= step) {
-                            nextOverlapData.hasCanDimer = true;
-                        }
-                    }
-                    lastCanonicalPos = matchPos;
-                    hasLastCanonical = true;
-                }
 
-                // Update windowData
-                if (alwaysMainWindow || j >= overlapSize) {
-                    if (isCanonical) {
-                        windowData.canonicalCounts++;
-                        windowData.canonicalCovered += matchLen;
-                        segmentData.canonicalMatches.push_back(matchInfo);
-                    } else {
-                        windowData.nonCanonicalCounts++;
-                        windowData.nonCanonicalCovered += matchLen;
-                        if (isTerminal) {
-                            segmentData.nonCanonicalMatches.push_back(matchInfo);
-                        }
-                    }
-
-                    // route by strand
-                    if (isForward) {
-                        windowData.fwdCounts++;
-                        windowData.fwdCovered += matchLen;
-                        segmentData.fwdMatches.push_back(matchInfo);
-                    } else {
-                        windowData.revCounts++;
-                        windowData.revCovered += matchLen;
-                        segmentData.revMatches.push_back(matchInfo);
-                    }
-                    segmentData.allMatches.push_back(matchInfo);
-                }
+WindowRecord Teloscope::makeWindowRecord(uint32_t windowSize, uint32_t totalCovered, uint32_t fwdCovered,
+                                        uint32_t canonicalCovered, const uint32_t nucleotideCounts[4]) {
+    WindowRecord record;
+    record.size = windowSize;
+    if (userInput.outWinRepeats) {
+        record.density = static_cast<float>(totalCovered) / windowSize;
+        record.canonicalRatio = (totalCovered > 0) ? static_cast<float>(canonicalCovered) / totalCovered : -1.0f;
+        record.strandRatio = (totalCovered > 0) ? static_cast<float>(fwdCovered) / totalCovered : -1.0f;
+    }
+    if (userInput.outGC) {
+        record.gcContent = getGCContent(nucleotideCounts, windowSize);
+    }
+    if (userInput.outEntropy) {
+        record.shannonEntropy = getShannonEntropy(nucleotideCounts, windowSize);
+    }
+    return record;
+}
 
-                // Update nextOverlapData
-                if (hasOverlap && i >= step) {
-                    if (isCanonical) {
-                        nextOverlapData.canonicalCounts++;
-                        nextOverlapData.canonicalCovered += matchLen;
-                    } else {
-                        nextOverlapData.nonCanonicalCounts++;
-                        nextOverlapData.nonCanonicalCovered += matchLen;
-                    }
-
-                    // fwd/rev overlap metrics
-                    if (isForward) {
-                        nextOverlapData.fwdCounts++;
-                        nextOverlapData.fwdCovered += matchLen;
-                    } else {
-                        nextOverlapData.revCounts++;
-                        nextOverlapData.revCovered += matchLen;
-                    }
-                }
 
+void Teloscope::scanWindowsOnePass(std::string_view sequence, uint64_t absPos,
+                                   uint64_t firstWindow, uint64_t lastWindow,
+                                   SegmentData& segmentData, BlockBuilder* blocks) {
+    // A window counts the matches it fully contains. A match starting before
+    // the window cannot end past it (the window is no shorter than a match
+    // except at the segment end), so the matches of [start, end) are those
+    // ending by end minus those starting before start. Matches are binned by
+    // start and by end on the step lattice, and two cursors walk the starts
+    // and the ends, so each base and match is touched a constant number of
+    // times however many windows overlap it. Window levels are multiples of
+    // the step, so their bounds are start-cursor positions and each level
+    // window is the difference of two of them. A range reads to the end of
+    // its last window, or a match past its end, and keeps the matches starting
+    // before the next range; ranges cut on every level size join into the
+    // output of a single one.
+    const uint64_t segmentSize = sequence.size();
+    const uint64_t windowSize = userInput.windowSize;
+    const uint64_t step = userInput.step;
+    const uint64_t terminalLimit = userInput.terminalLimit;
+    const uint64_t terminalEnd = (segmentSize > terminalLimit) ? (segmentSize - terminalLimit) : 0;
+    const bool needMatchSeq = userInput.outMatches;
+    const uint64_t windowCount = (segmentSize + step - 1) / step;
+    const size_t levelCount = windowLevelCount();
+
+    segmentData.windows.resize(levelCount);
+    if (firstWindow >= lastWindow) return;
+    const uint64_t binCount = lastWindow - firstWindow;
+    const uint64_t rangeStart = firstWindow * step;
+    const uint64_t rangeEnd = (lastWindow == windowCount) ? segmentSize : lastWindow * step;
+    const uint64_t scanEnd = std::min(std::max((lastWindow - 1) * step + windowSize,
+                                               rangeEnd + getLongestMatchSize() - 1), segmentSize);
+
+    struct Coverage {
+        uint32_t total = 0;
+        uint32_t fwd = 0;
+        uint32_t canonical = 0;
+
+        void add(const Coverage& other) {
+            total += other.total;
+            fwd += other.fwd;
+            canonical += other.canonical;
+        }
+    };
+    // [k - firstWindow]: matches starting in [k * step, (k + 1) * step),
+    // matches ending in (k * step + windowSize - step, k * step + windowSize],
+    // and for levels matches ending in (k * step, (k + 1) * step] and the
+    // starts of matches no window contains; the last bin takes what lies past
+    // the range. Running sums may wrap, the per-window differences stay exact.
+    thread_local std::vector<Coverage> byStart, byEnd, byLatticeEnd, crossingByStart;
+    byStart.assign(binCount + 1, Coverage());
+    byEnd.assign(binCount + 1, Coverage());
+    byLatticeEnd.assign(levelCount > 1 ? binCount + 1 : 0, Coverage());
+    crossingByStart.assign(levelCount > 1 ? binCount + 1 : 0, Coverage());
+
+    scanMotifs(sequence.data(), rangeStart, scanEnd,
+               [&](uint64_t i, uint16_t matchLen, bool isForward, bool isCanonical, uint8_t distance) {
+        const uint64_t window = i / step;
+        const uint64_t end = i + matchLen;
+        // a match crossing every window bound is neither a window match nor a
+        // block match; only a level window can still contain it
+        const bool crossesWindows = end > window * step + windowSize;
+        if (crossesWindows && levelCount == 1) return;
+
+        if (i < rangeEnd && !crossesWindows) {
+            MatchInfo matchInfo;
+            matchInfo.position = absPos + i;
+            matchInfo.isCanonical = isCanonical;
+            matchInfo.isForward = isForward;
+            matchInfo.matchSize = matchLen;
+            matchInfo.distance = distance;
+            matchInfo.isReported = isCanonical || i <= terminalLimit || i >= terminalEnd;
+
+            if (blocks != nullptr) blocks->add(matchInfo);
+            if (needMatchSeq && matchInfo.isReported) {
+                segmentData.matches.push_back(matchInfo, sequence.data() + i);
+            } else if (blocks == nullptr) {
+                segmentData.matches.push_back(matchInfo);
             }
+            if (isCanonical) segmentData.canonicalCount++;
+        }
+
+        Coverage match;
+        match.total = matchLen;
+        match.fwd = isForward ? matchLen : 0;
+        match.canonical = isCanonical ? matchLen : 0;
+        if (levelCount > 1) byLatticeEnd[std::min((end - 1) / step - firstWindow, binCount)].add(match);
+        if (crossesWindows) {
+            crossingByStart[std::min(window - firstWindow, binCount)].add(match);
+            return;
+        }
+        const uint64_t endWindow = (end <= windowSize) ? 0 : (end - windowSize + step - 1) / step;
+        byStart[std::min(window - firstWindow, binCount)].add(match);
+        byEnd[(endWindow > firstWindow) ? std::min(endWindow - firstWindow, binCount) : 0].add(match);
+    });
+
+    const bool countBases = userInput.outGC || userInput.outEntropy;
+    const auto &countBasesKernel = kernels::active().countBases;
+    uint32_t startBases[4] = {0, 0, 0, 0}, endBases[4] = {0, 0, 0, 0}; // bases between the range start and each cursor
+    uint64_t startCursor = rangeStart, endCursor = rangeStart;
+    Coverage beforeStart, byEndTotal; // matches starting before the window, ending by its end
+    Coverage byLatticeEndTotal; // matches ending by the start cursor
+    Coverage crossingBeforeStart; // matches no window contains, starting before the window
+    size_t endBinsSummed = 0;
+
+    // open window of each level: its start, and the sums at its start
+    struct LevelWindow {
+        uint64_t start = 0;
+        Coverage beforeStart;
+        uint32_t startBases[4] = {0, 0, 0, 0};
+    };
+    thread_local std::vector<LevelWindow> openLevels;
+    openLevels.assign(levelCount, LevelWindow());
+    for (LevelWindow& open : openLevels) open.start = rangeStart;
+
+    auto closeLevelWindow = [&](size_t level, uint64_t end, const Coverage& byEndSum, const uint32_t endBaseCounts[4]) {
+        LevelWindow& open = openLevels[level];
+        uint32_t windowBases[4];
+        for (int b = 0; b < 4; ++b) windowBases[b] = endBaseCounts[b] - open.startBases[b];
+        WindowRecord record = makeWindowRecord(static_cast<uint32_t>(end - open.start),
+                                               byEndSum.total - open.beforeStart.total,
+                                               byEndSum.fwd - open.beforeStart.fwd,
+                                               byEndSum.canonical - open.beforeStart.canonical,
+                                               windowBases);
+        record.startDelta = (open.start == 0) ? 0 : static_cast<uint32_t>(windowLevelStep(level));
+        segmentData.windows[level].push_back(record);
+    };
+
+    std::vector<WindowRecord>& windows = segmentData.windows[0];
+    windows.reserve(windows.size() + binCount);
+    for (uint64_t k = firstWindow; k < lastWindow; ++k) {
+        const uint64_t bin = k - firstWindow;
+        const uint64_t windowStart = k * step;
+        const uint64_t windowEnd = std::min(windowStart + windowSize, segmentSize);
+
+        for (; endBinsSummed <= bin || (windowEnd == segmentSize && endBinsSummed <= binCount); ++endBinsSummed) {
+            byEndTotal.add(byEnd[endBinsSummed]);
+        }
+        if (countBases) {
+            countBasesKernel(sequence.data() + startCursor, windowStart - startCursor, startBases);
+            countBasesKernel(sequence.data() + endCursor, windowEnd - endCursor, endBases);
+            startCursor = windowStart;
+            endCursor = windowEnd;
+        }
+
+        uint32_t windowBases[4];
+        for (int b = 0; b < 4; ++b) windowBases[b] = endBases[b] - startBases[b];
+        WindowRecord record = makeWindowRecord(static_cast<uint32_t>(windowEnd - windowStart),
+                                               byEndTotal.total - beforeStart.total,
+                                               byEndTotal.fwd - beforeStart.fwd,
+                                               byEndTotal.canonical - beforeStart.canonical,
+                                               windowBases);
+        record.startDelta = (k == 0) ? 0 : static_cast<uint32_t>(step);
+        windows.push_back(record);
+
+        // level windows ending at this start
+        for (size_t level = 1; level < levelCount; ++level) {
+            if (windowStart == rangeStart || windowStart % windowLevelStep(level) != 0) continue;
+            closeLevelWindow(level, windowStart, byLatticeEndTotal, startBases);
+            openLevels[level].start = windowStart;
+            openLevels[level].beforeStart = beforeStart;
+            openLevels[level].beforeStart.add(crossingBeforeStart);
+            std::copy(startBases, startBases + 4, openLevels[level].startBases);
+        }
+
+        beforeStart.add(byStart[bin]);
+        if (levelCount > 1) {
+            byLatticeEndTotal.add(byLatticeEnd[bin]);
+            crossingBeforeStart.add(crossingByStart[bin]);
+        }
+    }
+
+    // last level windows end with the range
+    if (levelCount > 1) {
+        if (countBases) countBasesKernel(sequence.data() + startCursor, rangeEnd - startCursor, startBases);
+        for (size_t level = 1; level < levelCount; ++level) {
+            closeLevelWindow(level, rangeEnd, byLatticeEndTotal, startBases);
         }
     }
 }
 
 
-SegmentData Teloscope::scanSegment(std::string &sequence, uint64_t absPos, bool tipsOnly) {
-    SegmentData segmentData;
+void Teloscope::scanWindowChunks(std::string_view sequence, uint64_t absPos,
+                                 SegmentData& segmentData, BlockBuilder& blocks) {
+    const uint64_t step = userInput.step;
+    const uint64_t windowCount = (sequence.size() + step - 1) / step;
+
+    // chunks start on every level bound, so no level window is cut
+    uint64_t alignWindows = 1;
+    for (uint32_t level : userInput.windowLevels) alignWindows = std::lcm(alignWindows, uint64_t(level / step));
+    const uint64_t chunkWindows = alignWindows * std::max<uint64_t>(1, windowChunkBases / (alignWindows * step));
+    const uint64_t chunkCount = (windowCount + chunkWindows - 1) / chunkWindows;
+
+    if (chunkCount < 2 || threadPool.totalThreads() < 2) {
+        scanWindowsOnePass(sequence, absPos, 0, windowCount, segmentData, &blocks);
+        return;
+    }
+
+    // a chunk keeps its matches until it is joined, so only a few chunks
+    // are scanned ahead of the join; a buffer is reused inFlight chunks later
+    const size_t inFlight = std::min<uint64_t>(chunkCount, 2 * threadPool.totalThreads());
+    thread_local std::vector<SegmentData> chunkBuffers; // keep their storage for the next long segment
+    std::vector<SegmentData>& chunks = chunkBuffers; // the workers fill this thread's buffers
+    if (chunks.size() < inFlight) chunks.resize(inFlight);
+
+    segmentData.windows.resize(windowLevelCount());
+    runOnIdleWorkers(chunkCount, inFlight, [&](size_t chunk) {
+        const uint64_t firstWindow = chunk * chunkWindows;
+        SegmentData& chunkData = chunks[chunk % inFlight];
+        chunkData.clear();
+        scanWindowsOnePass(sequence, absPos, firstWindow, std::min(firstWindow + chunkWindows, windowCount),
+                           chunkData, nullptr);
+    }, [&](size_t chunk) {
+        // joined in order, the chunks give the windows, matches and blocks of one pass
+        const SegmentData& chunkData = chunks[chunk % inFlight];
+        for (size_t level = 0; level < chunkData.windows.size(); ++level) {
+            segmentData.windows[level].insert(segmentData.windows[level].end(),
+                                              chunkData.windows[level].begin(), chunkData.windows[level].end());
+        }
+        for (size_t i = 0; i < chunkData.matches.size(); ++i) blocks.add(chunkData.matches[i]);
+        if (userInput.outMatches) segmentData.matches.append(chunkData.matches.reported());
+        segmentData.canonicalCount += chunkData.canonicalCount;
+    });
+}
+
+
+void Teloscope::scanSegment(std::string_view sequence, uint64_t absPos, bool tipsOnly, SegmentData& segmentData) {
+    segmentData.clear();
     uint64_t segmentSize = sequence.size();
     uint32_t terminalLimit = userInput.terminalLimit;
-    unsigned short int longestPatternSize = this->trie.getLongestPatternSize();
+    thread_local BlockBuilder blocks;
+    blocks.reset(userInput, segmentSize, absPos, !tipsOnly);
 
     if (tipsOnly) {
         // ========== Fast path: terminal scan only ==========
+
+        // matches starting before startsEnd
+        auto processRegion = [&](uint64_t start, uint64_t end, uint64_t startsEnd) {
+            scanMotifs(sequence.data(), start, end,
+                       [&](uint64_t i, uint16_t len, bool isForward, bool isCanonical, uint8_t distance) {
+                if (i >= startsEnd) return;
+
+                MatchInfo matchInfo;
+                matchInfo.position = absPos + i;
+                matchInfo.isCanonical = isCanonical;
+                matchInfo.isForward = isForward;
+                matchInfo.matchSize = len;
+                matchInfo.distance = distance;
+                segmentData.matches.push_back(matchInfo);
+            });
+        };
         
-        auto processRegion = [&](uint64_t start, uint64_t end) {
-            for (uint64_t i = start; i < end; ++i) {
-                int32_t node = trie.getRoot();
-                uint64_t scanLimit = std::min(i + static_cast<uint64_t>(longestPatternSize), end);
-
-                for (uint64_t j = i; j < scanLimit; ++j) {
-                    node = trie.getChild(node, sequence[j]);
-                    if (node < 0) break;
-
-                    if (trie.isEnd(node)) {
-                        uint16_t len = static_cast<uint16_t>(j - i + 1);
-                        bool isForward = trie.isForward(node);
-                        bool isCanonical = trie.isCanonical(node);
-
-                        MatchInfo matchInfo;
-                        matchInfo.position = absPos + i;
-                        matchInfo.isCanonical = isCanonical;
-                        matchInfo.isForward = isForward;
-                        matchInfo.matchSize = len;
-
-                        if (isForward) {
-                            segmentData.fwdMatches.push_back(matchInfo);
-                        } else {
-                            segmentData.revMatches.push_back(matchInfo);
-                        }
-                    }
+        if (userInput.adaptiveExtent > 0) {
+            // Adaptive extent: walk each tip inward in chunks, following the
+            // chains that make its sub-blocks (forward at p, reverse at q, and
+            // both when the terminal zones overlap). The walk stops once no chain can still grow and the last chain
+            // that may be a sub-block ended more than max(adaptiveExtent, -d)
+            // bp before, so no unscanned match can join or merge with a block
+            // of the scanned stretch, which then matches the full scan. Chunks
+            // cover disjoint match starts; depths are measured from the tip.
+            const uint64_t chunk = std::max<uint64_t>(userInput.adaptiveExtent / 2, 1024);
+            const uint64_t overhang = getLongestMatchSize() - 1;
+            const uint64_t stopDepth = std::max<uint64_t>(userInput.adaptiveExtent, userInput.maxBlockDist);
+            const bool twoTips = segmentSize > 2 * terminalLimit;
+            const uint64_t pStartsEnd = twoTips ? terminalLimit : segmentSize / 2;
+            const uint64_t pScanEnd = twoTips ? terminalLimit : segmentSize;
+            const uint64_t qStartsBegin = twoTips ? segmentSize - terminalLimit : pStartsEnd;
+
+            struct TipChain {
+                bool open = false;
+                uint64_t prevPosition = 0;  // start of the last match, walking inward
+                uint64_t innerDepth = 0;    // innermost base of the open chain
+                uint32_t counts = 0, canonicalCount = 0;
+                uint64_t subBlockDepth = 0; // innermost base of the chains that may be sub-blocks
+            };
+            // a superset of closeSubBlock: density is left out, so the walk never stops short
+            auto close = [&](TipChain& tip) {
+                if (tip.open && tip.counts >= userInput.minBlockCounts && tip.canonicalCount > 0) {
+                    tip.subBlockDepth = std::max(tip.subBlockDepth, tip.innerDepth);
+                }
+                tip.open = false;
+            };
+            auto follow = [&](TipChain& tip, const MatchInfo& m, uint64_t innerDepth) {
+                const uint64_t i = m.position - absPos;
+                const uint64_t gap = i > tip.prevPosition ? i - tip.prevPosition : tip.prevPosition - i;
+                if (!tip.open || gap > userInput.maxMatchDist) {
+                    close(tip);
+                    tip.open = true;
+                    tip.counts = 0;
+                    tip.canonicalCount = 0;
+                }
+                tip.prevPosition = i;
+                tip.innerDepth = std::max(tip.innerDepth, innerDepth);
+                tip.counts++;
+                tip.canonicalCount += m.isCanonical;
+            };
+            // unscanned matches start nextGap bp past the last one and reach up to frontier
+            auto canStop = [&](TipChain& tip, uint64_t nextGap, uint64_t frontier) {
+                if (tip.open && nextGap > userInput.maxMatchDist) close(tip);
+                return !tip.open && frontier > tip.subBlockDepth + stopDepth;
+            };
+
+            TipChain pTips[2], qTips[2]; // [isForward]
+            bool pStopped = false;
+            for (uint64_t chunkStart = 0; chunkStart < pStartsEnd && !pStopped; chunkStart += chunk) {
+                uint64_t chunkEnd = std::min(chunkStart + chunk, pStartsEnd);
+                const size_t first = segmentData.matches.size();
+                processRegion(chunkStart, std::min(chunkEnd + overhang, pScanEnd), chunkEnd);
+                for (size_t index = first; index < segmentData.matches.size(); ++index) {
+                    const MatchInfo m = segmentData.matches[index];
+                    if (m.isForward || !twoTips) follow(pTips[m.isForward], m, m.position - absPos + m.matchSize);
                 }
+                pStopped = true;
+                for (TipChain& tip : pTips) pStopped &= canStop(tip, chunkEnd - tip.prevPosition, chunkEnd);
             }
-        };
-        
-        if (segmentSize > 2 * terminalLimit) {
+
+            const size_t qTail = segmentData.matches.size();
+            bool qStopped = false;
+            for (uint64_t chunkEnd = segmentSize; chunkEnd > qStartsBegin && !qStopped; ) {
+                uint64_t chunkStart = chunkEnd - std::min(chunk, chunkEnd - qStartsBegin);
+                const size_t first = segmentData.matches.size();
+                processRegion(chunkStart, std::min(chunkEnd + overhang, segmentSize), chunkEnd);
+                for (size_t index = segmentData.matches.size(); index > first; --index) {
+                    const MatchInfo m = segmentData.matches[index - 1];
+                    if (!m.isForward || !twoTips) follow(qTips[m.isForward], m, segmentSize - (m.position - absPos));
+                }
+                // the ends of unscanned matches reach up to overhang bp into the chunk
+                qStopped = true;
+                for (TipChain& tip : qTips) {
+                    qStopped &= chunkStart == 0 ||
+                        canStop(tip, tip.prevPosition - (chunkStart - 1),
+                                segmentSize - std::min(chunkStart - 1 + getLongestMatchSize(), segmentSize));
+                }
+                chunkEnd = chunkStart;
+            }
+
+            if (!twoTips && (!pStopped || !qStopped)) {
+                // a walk reached the middle with a block still open: the other
+                // half may hold its continuation, so scan the contig whole
+                segmentData.matches.clear();
+                processRegion(0, segmentSize, segmentSize);
+            } else {
+                // the q tip was collected inward, restore start order
+                segmentData.matches.sortFrom(qTail);
+            }
+        } else if (segmentSize > 2 * terminalLimit) {
             // Process terminal regions only
-            processRegion(0, terminalLimit);
-            processRegion(segmentSize - terminalLimit, segmentSize);
+            processRegion(0, terminalLimit, terminalLimit);
+            processRegion(segmentSize - terminalLimit, segmentSize, segmentSize);
         } else {
             // Process entire contig
-            processRegion(0, segmentSize);
+            processRegion(0, segmentSize, segmentSize);
         }
 
+    } else if (userInput.windowSize >= getLongestMatchSize()) {
+        // ========== Full path: every window in one pass ==========
+        // levels also count the matches that cross -w window bounds
+        scanWindowChunks(sequence, absPos, segmentData, blocks);
+
     } else {
-        // ========== Full path: window-based scan ==========
+        // ========== Full path: window-based scan, windows shorter than a match ==========
         uint32_t windowSize = userInput.windowSize;
         uint32_t step = userInput.step;
 
-        // capped reserve
-        constexpr uint64_t maxMatchReserve = 1000000;
-        segmentData.canonicalMatches.reserve(std::min(segmentSize / 6, maxMatchReserve));
-        segmentData.nonCanonicalMatches.reserve(std::min(segmentSize / 6, maxMatchReserve));
-        segmentData.allMatches.reserve(std::min(segmentSize / 3, maxMatchReserve));
-
+        segmentData.windows.resize(1);
         if (segmentSize > windowSize) {
-            segmentData.windows.reserve((segmentSize - windowSize) / step + 2);
+            segmentData.windows[0].reserve((segmentSize - windowSize) / step + 2);
         }
 
         WindowData prevOverlapData; // Data from previous overlap
         WindowData nextOverlapData; // Data for next overlap
 
-        std::vector<WindowData> windows;
+        std::vector<WindowRecord>& windows = segmentData.windows[0];
         uint64_t windowStart = 0;
         uint64_t currentWindowSize = std::min(static_cast<uint64_t>(windowSize), segmentSize);
         std::string_view windowView(sequence.data(), currentWindowSize);
@@ -611,19 +1030,15 @@ SegmentData Teloscope::scanSegment(std::string &sequence, uint64_t absPos, bool
 
             analyzeWindow(windowView, windowStart, 
                         windowData, nextOverlapData, 
-                        segmentData, segmentSize, absPos);
+                        segmentData, blocks, segmentSize, absPos);
 
-            if (userInput.outGC) { 
-                windowData.gcContent = getGCContent(windowData.nucleotideCounts, windowView.size()); 
-            }
-            if (userInput.outEntropy) { 
-                windowData.shannonEntropy = getShannonEntropy(windowData.nucleotideCounts, windowView.size()); 
-            }
-            
-            // Update windowData
-            windowData.windowStart = windowStart + absPos;
-            windowData.currentWindowSize = currentWindowSize;
-            windows.emplace_back(windowData);
+            // Keep only the reported metrics
+            WindowRecord record = makeWindowRecord(static_cast<uint32_t>(currentWindowSize),
+                                                   windowData.fwdCovered + windowData.revCovered,
+                                                   windowData.fwdCovered, windowData.canonicalCovered,
+                                                   windowData.nucleotideCounts);
+            record.startDelta = windows.empty() ? 0 : step;
+            windows.push_back(record);
 
             prevOverlapData = nextOverlapData;
             nextOverlapData = WindowData();
@@ -635,34 +1050,20 @@ SegmentData Teloscope::scanSegment(std::string &sequence, uint64_t absPos, bool
             currentWindowSize = std::min(static_cast<uint64_t>(windowSize), segmentSize - windowStart);
             windowView = std::string_view(sequence.data() + windowStart, currentWindowSize);
         }
-
-        segmentData.windows = std::move(windows);
     }
 
     // ========== Block creation ==========
-    uint64_t fwdBoundary = absPos;
-    uint64_t revBoundary = absPos + segmentSize;
-
-    if (segmentData.fwdMatches.size() >= 2)
-        fwdBoundary = getTerminalBlocks(segmentData.fwdMatches, segmentData.terminalBlocks,
-                                         segmentSize, absPos, true);
-    if (segmentData.revMatches.size() >= 2)
-        revBoundary = getTerminalBlocks(segmentData.revMatches, segmentData.terminalBlocks,
-                                         segmentSize, absPos, false);
-
-    if (!tipsOnly && fwdBoundary < revBoundary && segmentData.allMatches.size() >= 2)
-        getInterstitialBlocks(segmentData.allMatches, segmentData.interstitialBlocks,
-                              fwdBoundary, revBoundary);
-
-    return segmentData;
+    if (tipsOnly) {
+        // tip matches are few, and the adaptive scan collects the q tip inward
+        const MatchStore& matches = segmentData.matches;
+        for (size_t i = 0; i < matches.size(); ++i) blocks.add(matches[i]);
+        segmentData.matches.clear();
+    }
+    blocks.finish(segmentData.terminalBlocks, segmentData.interstitialBlocks);
 }
 
 
-void Teloscope::writeBEDFile(std::ofstream& windowDensityFile,
-                            std::ofstream& windowCanonicalRatioFile,
-                            std::ofstream& windowStrandRatioFile,
-                            std::ofstream& windowGCFile,
-                            std::ofstream& windowEntropyFile,
+void Teloscope::writeBEDFile(std::vector<WindowTracks>& windowTracks,
                             std::ofstream& canonicalMatchFile,
                             std::ofstream& noncanonicalMatchFile,
                             std::ofstream& terminalBlocksFile,
@@ -670,17 +1071,21 @@ void Teloscope::writeBEDFile(std::ofstream& windowDensityFile,
                             std::ofstream& gapFile,
                             std::ofstream& reportFile) {
 
-    // BEDgraph headers
-    if (userInput.outWinRepeats) {
-        windowDensityFile << "track type=bedGraph name=\"Repeat Density\" description=\"Total repeat density per window\"\n";
-        windowCanonicalRatioFile << "track type=bedGraph name=\"Canonical Ratio\" description=\"Canonical fraction of repeat density per window\"\n";
-        windowStrandRatioFile << "track type=bedGraph name=\"Strand Ratio\" description=\"Forward-strand fraction of repeat density per window\"\n";
-    }
-    if (userInput.outEntropy) {
-        windowEntropyFile << "track type=bedGraph name=\"Shannon Entropy\" description=\"Shannon entropy per window\"\n";
-    }
-    if (userInput.outGC) {
-        windowGCFile << "track type=bedGraph name=\"GC Content\" description=\"GC content per window\"\n";
+    // BEDgraph headers, window levels name their size
+    for (size_t level = 0; level < windowTracks.size(); ++level) {
+        WindowTracks& tracks = windowTracks[level];
+        const std::string size = level == 0 ? "" : " " + std::to_string(windowLevelStep(level)) + " bp";
+        if (userInput.outWinRepeats) {
+            tracks.density << "track type=bedGraph name=\"Repeat Density" << size << "\" description=\"Total repeat density per window\"\n";
+            tracks.canonicalRatio << "track type=bedGraph name=\"Canonical Ratio" << size << "\" description=\"Canonical fraction of repeat density per window\"\n";
+            tracks.strandRatio << "track type=bedGraph name=\"Strand Ratio" << size << "\" description=\"Forward-strand fraction of repeat density per window\"\n";
+        }
+        if (userInput.outEntropy) {
+            tracks.entropy << "track type=bedGraph name=\"Shannon Entropy" << size << "\" description=\"Shannon entropy per window\"\n";
+        }
+        if (userInput.outGC) {
+            tracks.gc << "track type=bedGraph name=\"GC Content" << size << "\" description=\"GC content per window\"\n";
+        }
     }
 
     // Report header (console + file)
@@ -696,10 +1101,13 @@ void Teloscope::writeBEDFile(std::ofstream& windowDensityFile,
     // Processing paths
     totalPaths = allPathData.size();
     std::vector<float> telomereLengths; // for getStats
+    std::vector<WindowRecord> windows; // current path and level, read back from the spill
+    uint64_t pathWindowCount = 0; // -w/-s windows of the current path
+    MatchStore spilledMatches; // current path under --max-memory, spilled then held matches
+    std::vector<char> spillBytes;
 
     for (const auto& pathData : allPathData) {
         const auto& header = pathData.header;
-        const auto& windows = pathData.windows;
         const auto& pos = pathData.seqPos;
         const uint16_t gaps = static_cast<uint16_t>(pathData.gapInfos.size());
         const auto& pathSize = pathData.pathSize;
@@ -766,49 +1174,73 @@ void Teloscope::writeBEDFile(std::ofstream& windowDensityFile,
 
         // All canonical and terminal non-canonical matches
         if (userInput.outMatches) {
-            for (const auto& match : pathData.canonicalMatches) {
-                canonicalMatchFile << header << "\t"
-                                << match.position << "\t"
-                                << (match.position + match.matchSize) << "\t"
-                                << match.matchSeq << "\n";
+            const MatchStore* store = &pathData.matches;
+            if (!pathData.spilledMatches.empty()) {
+                spilledMatches.clear();
+                for (const auto& extent : pathData.spilledMatches) {
+                    spillBytes.resize(extent.bytes);
+                    spill.read(extent, spillBytes.data());
+                    spilledMatches.deserialize(spillBytes.data(), spillBytes.size());
+                }
+                spilledMatches.append(pathData.matches.all());
+                store = &spilledMatches;
             }
+            const MatchStore& matches = *store;
+            // bit-parallel matches also carry their edit distance (score) and strand
+            const bool withDistance = approxMatcher.isActive();
+            auto writeMatch = [&](std::ofstream& file, size_t i) {
+                const MatchInfo match = matches[i];
+                file << header << "\t"
+                     << match.position << "\t"
+                     << (match.position + match.matchSize) << "\t"
+                     << matches.sequence(i);
+                if (withDistance) {
+                    file << "\t" << static_cast<unsigned>(match.distance)
+                         << "\t" << (match.isForward ? '+' : '-');
+                }
+                file << "\n";
+            };
 
-            for (const auto& match : pathData.nonCanonicalMatches) {
-                noncanonicalMatchFile << header << "\t"
-                                    << match.position << "\t"
-                                    << (match.position + match.matchSize) << "\t"
-                                    << match.matchSeq << "\n";
+            const MatchStore::View canonicalMatches = matches.canonical();
+            for (size_t i = canonicalMatches.first(); i != MatchStore::npos; i = canonicalMatches.next(i + 1)) {
+                writeMatch(canonicalMatchFile, i);
             }
-        }
 
-        // Process window metrics
-        for (const auto& window : windows) {
-            uint64_t windowEnd = window.windowStart + window.currentWindowSize;
-
-            if (userInput.outWinRepeats) {
-                uint32_t totalCovered = window.fwdCovered + window.revCovered;
-                float totalDensity = static_cast<float>(totalCovered) / window.currentWindowSize;
-                float canonRatio = (totalCovered > 0)
-                    ? static_cast<float>(window.canonicalCovered) / (window.canonicalCovered + window.nonCanonicalCovered)
-                    : -1.0f;
-                float strandRatio = (totalCovered > 0)
-                    ? static_cast<float>(window.fwdCovered) / (window.fwdCovered + window.revCovered)
-                    : -1.0f;
-
-                windowDensityFile << header << "\t" << window.windowStart << "\t" << windowEnd
-                                    << "\t" << totalDensity << "\n";
-                windowCanonicalRatioFile << header << "\t" << window.windowStart << "\t" << windowEnd
-                                           << "\t" << canonRatio << "\n";
-                windowStrandRatioFile << header << "\t" << window.windowStart << "\t" << windowEnd
-                                        << "\t" << strandRatio << "\n";
+            const MatchStore::View nonCanonicalMatches = matches.reportedNonCanonical();
+            for (size_t i = nonCanonicalMatches.first(); i != MatchStore::npos; i = nonCanonicalMatches.next(i + 1)) {
+                writeMatch(noncanonicalMatchFile, i);
             }
-            if (userInput.outEntropy) {
-                windowEntropyFile << header << "\t" << window.windowStart << "\t" << windowEnd
+        }
+
+        // Process window metrics, one track set per level
+        pathWindowCount = 0;
+        for (size_t level = 0; level < pathData.windows.size(); ++level) {
+            WindowTracks& tracks = windowTracks[level];
+            spill.read(pathData.windows[level], windows);
+
+            uint64_t windowStart = 0;
+            for (const auto& window : windows) {
+                windowStart += window.startDelta;
+                if (window.size == 0) continue; // skip record
+                if (level == 0) pathWindowCount++;
+                uint64_t windowEnd = windowStart + window.size;
+
+                if (userInput.outWinRepeats) {
+                    tracks.density << header << "\t" << windowStart << "\t" << windowEnd
+                                    << "\t" << window.density << "\n";
+                    tracks.canonicalRatio << header << "\t" << windowStart << "\t" << windowEnd
+                                           << "\t" << window.canonicalRatio << "\n";
+                    tracks.strandRatio << header << "\t" << windowStart << "\t" << windowEnd
+                                        << "\t" << window.strandRatio << "\n";
+                }
+                if (userInput.outEntropy) {
+                    tracks.entropy << header << "\t" << windowStart << "\t" << windowEnd
                                     << "\t" << window.shannonEntropy << "\n";
-            }
-            if (userInput.outGC) {
-                windowGCFile << header << "\t" << window.windowStart << "\t" << windowEnd
+                }
+                if (userInput.outGC) {
+                    tracks.gc << header << "\t" << windowStart << "\t" << windowEnd
                                << "\t" << window.gcContent << "\n";
+                }
             }
         }
 
@@ -830,18 +1262,19 @@ void Teloscope::writeBEDFile(std::ofstream& windowDensityFile,
 
         // Expand path summary
         if (!userInput.ultraFastMode) {
+            const uint64_t canonicalCount = pathData.canonicalCount;
             std::cout << "\t"
                     << pathData.interstitialBlocks.size() << "\t"
-                    << pathData.canonicalMatches.size() << "\t"
-                    << windows.size();
+                    << canonicalCount << "\t"
+                    << pathWindowCount;
             reportFile << "\t"
                     << pathData.interstitialBlocks.size() << "\t"
-                    << pathData.canonicalMatches.size() << "\t"
-                    << windows.size();
+                    << canonicalCount << "\t"
+                    << pathWindowCount;
 
-            totalNWindows += windows.size();
+            totalNWindows += pathWindowCount;
             totalITS += pathData.interstitialBlocks.size();
-            totalCanMatches += pathData.canonicalMatches.size();
+            totalCanMatches += canonicalCount;
         }
         std::cout << "\n";
         reportFile << "\n";
@@ -865,17 +1298,11 @@ void Teloscope::handleBEDFile() {
     constexpr size_t ioBufSize = 1 << 20; // 1MB write buffer per file
 
     // buffers must outlive the ofstreams that reference them
-    std::vector<char> densityBuf(ioBufSize), canonRatioBuf(ioBufSize), strandRatioBuf(ioBufSize);
-    std::vector<char> gcBuf(ioBufSize), entropyBuf(ioBufSize);
     std::vector<char> canonMatchBuf(ioBufSize), noncanonMatchBuf(ioBufSize);
     std::vector<char> termBlockBuf(ioBufSize), itsBlockBuf(ioBufSize), gapBuf(ioBufSize);
     std::vector<char> reportBuf(ioBufSize);
 
-    std::ofstream windowDensityFile;
-    std::ofstream windowCanonicalRatioFile;
-    std::ofstream windowStrandRatioFile;
-    std::ofstream windowGCFile;
-    std::ofstream windowEntropyFile;
+    std::vector<WindowTracks> windowTracks(windowLevelCount()); // built in place, streams keep their buffers
     std::ofstream canonicalMatchFile;
     std::ofstream noncanonicalMatchFile;
     std::ofstream terminalBlocksFile;
@@ -894,16 +1321,26 @@ void Teloscope::handleBEDFile() {
         }
     };
 
-    if (userInput.outWinRepeats) {
-        openFile(windowDensityFile, base + "_window_repeat_density.bedgraph", densityBuf);
-        openFile(windowCanonicalRatioFile, base + "_window_canonical_ratio.bedgraph", canonRatioBuf);
-        openFile(windowStrandRatioFile, base + "_window_strand_ratio.bedgraph", strandRatioBuf);
-    }
-    if (userInput.outGC) {
-        openFile(windowGCFile, base + "_window_gc.bedgraph", gcBuf);
-    }
-    if (userInput.outEntropy) {
-        openFile(windowEntropyFile, base + "_window_entropy.bedgraph", entropyBuf);
+    // -w/-s tracks are *_window_*, window levels *_window<size>_*
+    for (size_t level = 0; level < windowTracks.size(); ++level) {
+        WindowTracks& tracks = windowTracks[level];
+        const std::string prefix = base + "_window" + (level == 0 ? "" : std::to_string(windowLevelStep(level))) + "_";
+        if (userInput.outWinRepeats) {
+            tracks.densityBuf.resize(ioBufSize);
+            tracks.canonicalRatioBuf.resize(ioBufSize);
+            tracks.strandRatioBuf.resize(ioBufSize);
+            openFile(tracks.density, prefix + "repeat_density.bedgraph", tracks.densityBuf);
+            openFile(tracks.canonicalRatio, prefix + "canonical_ratio.bedgraph", tracks.canonicalRatioBuf);
+            openFile(tracks.strandRatio, prefix + "strand_ratio.bedgraph", tracks.strandRatioBuf);
+        }
+        if (userInput.outGC) {
+            tracks.gcBuf.resize(ioBufSize);
+            openFile(tracks.gc, prefix + "gc.bedgraph", tracks.gcBuf);
+        }
+        if (userInput.outEntropy) {
+            tracks.entropyBuf.resize(ioBufSize);
+            openFile(tracks.entropy, prefix + "entropy.bedgraph", tracks.entropyBuf);
+        }
     }
 
     if (userInput.outMatches) {
@@ -919,9 +1356,7 @@ void Teloscope::handleBEDFile() {
     openFile(gapFile, base + "_gaps.bed", gapBuf);
     openFile(reportFile, base + "_report.tsv", reportBuf);
 
-    writeBEDFile(windowDensityFile, windowCanonicalRatioFile,
-                windowStrandRatioFile,
-                windowGCFile, windowEntropyFile,
+    writeBEDFile(windowTracks,
                 canonicalMatchFile, noncanonicalMatchFile,
                 terminalBlocksFile, interstitialBlocksFile,
                 gapFile, reportFile);
@@ -930,16 +1365,18 @@ void Teloscope::handleBEDFile() {
     reportFile.close();
 
     // Close all files
-    if (userInput.outWinRepeats) {
-        windowDensityFile.close();
-        windowCanonicalRatioFile.close();
-        windowStrandRatioFile.close();
-    }
-    if (userInput.outGC) {
-        windowGCFile.close();
-    }
-    if (userInput.outEntropy) {
-        windowEntropyFile.close();
+    for (auto& tracks : windowTracks) {
+        if (userInput.outWinRepeats) {
+            tracks.density.close();
+            tracks.canonicalRatio.close();
+            tracks.strandRatio.close();
+        }
+        if (userInput.outGC) {
+            tracks.gc.close();
+        }
+        if (userInput.outEntropy) {
+            tracks.entropy.close();
+        }
     }
 
     if (userInput.outMatches) {
@@ -198,52 +198,54 @@ std::vector<std::string> expandPatterns(
 }
 
 
+// orientation of a literal pattern: closer to canonicalFwd than to its reverse complement
+bool isCloserToFwd(const std::string &pattern, const std::string &canonicalFwd) {
+    std::string canonicalRev = revCom(canonicalFwd);
+    size_t patLen = pattern.size();
+    size_t canLen = canonicalFwd.size();
+    
+    // same length: Hamming
+    if (patLen == canLen) {
+        uint8_t distFwd = 0, distRev = 0;
+        for (size_t i = 0; i < patLen; ++i) {
+            if (pattern[i] != canonicalFwd[i]) ++distFwd;
+            if (pattern[i] != canonicalRev[i]) ++distRev;
+        }
+        // tie-break: lex-smaller canonical wins
+        return distFwd <= distRev;
+    }
+    
+    // different lengths: best alignment
+    const std::string &shorter = (patLen < canLen) ? pattern : canonicalFwd;
+    const std::string &longer = (patLen < canLen) ? canonicalFwd : pattern;
+    const std::string longerRev = (patLen < canLen) ? canonicalRev : revCom(pattern);
+    size_t shortLen = shorter.size();
+    size_t longLen = longer.size();
+    
+    uint8_t minDistFwd = 255, minDistRev = 255;
+    for (size_t offset = 0; offset <= longLen - shortLen; ++offset) {
+        uint8_t dist = 0;
+        for (size_t i = 0; i < shortLen; ++i) {
+            if (shorter[i] != longer[offset + i]) ++dist;
+        }
+        minDistFwd = std::min(minDistFwd, dist);
+    }
+    for (size_t offset = 0; offset <= longLen - shortLen; ++offset) {
+        uint8_t dist = 0;
+        for (size_t i = 0; i < shortLen; ++i) {
+            if (shorter[i] != longerRev[offset + i]) ++dist;
+        }
+        minDistRev = std::min(minDistRev, dist);
+    }
+    return minDistFwd <= minDistRev;
+}
+
+
 std::vector<std::pair<std::string, bool>> expandPatternsWithOrientation(
     const std::vector<std::string> &rawPatterns,
     uint8_t editDistance,
     const std::string &canonicalFwd) {
 
-    auto isCloserToFwd = [&](const std::string &pattern) -> bool {
-        std::string canonicalRev = revCom(canonicalFwd);
-        size_t patLen = pattern.size();
-        size_t canLen = canonicalFwd.size();
-        
-        // same length: Hamming
-        if (patLen == canLen) {
-            uint8_t distFwd = 0, distRev = 0;
-            for (size_t i = 0; i < patLen; ++i) {
-                if (pattern[i] != canonicalFwd[i]) ++distFwd;
-                if (pattern[i] != canonicalRev[i]) ++distRev;
-            }
-            // tie-break: lex-smaller canonical wins
-            return distFwd <= distRev;
-        }
-        
-        // different lengths: best alignment
-        const std::string &shorter = (patLen < canLen) ? pattern : canonicalFwd;
-        const std::string &longer = (patLen < canLen) ? canonicalFwd : pattern;
-        const std::string longerRev = (patLen < canLen) ? canonicalRev : revCom(pattern);
-        size_t shortLen = shorter.size();
-        size_t longLen = longer.size();
-        
-        uint8_t minDistFwd = 255, minDistRev = 255;
-        for (size_t offset = 0; offset <= longLen - shortLen; ++offset) {
-            uint8_t dist = 0;
-            for (size_t i = 0; i < shortLen; ++i) {
-                if (shorter[i] != longer[offset + i]) ++dist;
-            }
-            minDistFwd = std::min(minDistFwd, dist);
-        }
-        for (size_t offset = 0; offset <= longLen - shortLen; ++offset) {
-            uint8_t dist = 0;
-            for (size_t i = 0; i < shortLen; ++i) {
-                if (shorter[i] != longerRev[offset + i]) ++dist;
-            }
-            minDistRev = std::min(minDistRev, dist);
-        }
-        return minDistFwd <= minDistRev;
-    };
-
     std::vector<std::pair<std::string, bool>> result;
     
     for (const auto &seed : rawPatterns) {
@@ -254,7 +256,7 @@ std::vector<std::pair<std::string, bool>> expandPatternsWithOrientation(
         getCombinations(seed, working, 0, combinations);
 
         for (const auto &combo : combinations) {
-            bool seedIsForward = isCloserToFwd(combo);
+            bool seedIsForward = isCloserToFwd(combo, canonicalFwd);
             
             std::vector<std::string> variants;
             variants.push_back(combo);
@@ -280,4 +282,151 @@ std::vector<std::pair<std::string, bool>> expandPatternsWithOrientation(
         result.end());
 
     return result;
-}
\ No newline at end of file
+}
+
+
+std::string revComClasses(const std::string &seed) {
+    static const std::unordered_map<char, char> complement = {
+        {'A', 'T'}, {'C', 'G'}, {'G', 'C'}, {'T', 'A'},
+        {'R', 'Y'}, {'Y', 'R'}, {'M', 'K'}, {'K', 'M'}, {'S', 'S'}, {'W', 'W'},
+        {'H', 'D'}, {'D', 'H'}, {'B', 'V'}, {'V', 'B'}, {'N', 'N'}
+    };
+    std::string rc(seed.rbegin(), seed.rend());
+    for (char &c : rc) c = complement.at(c);
+    return rc;
+}
+
+
+uint64_t countSeedCombinations(const std::string &seed) {
+    uint64_t combinationCount = 1;
+    for (char c : seed) {
+        auto it = IUPAC.find(c);
+        if (it == IUPAC.end()) return 0;
+        combinationCount = std::min(combinationCount * it->second.size(), maxOrientationChecks + 1);
+    }
+    return combinationCount;
+}
+
+
+std::vector<std::pair<std::string, bool>> getSeedsWithOrientation(
+    const std::vector<std::string> &rawPatterns,
+    const std::string &canonicalFwd) {
+
+    std::vector<std::pair<std::string, bool>> result;
+
+    for (const auto &seed : rawPatterns) {
+        if (seed.empty()) continue;
+
+        uint64_t combinationCount = countSeedCombinations(seed);
+        if (combinationCount == 0) continue;
+
+        std::vector<std::string> combinations;
+        std::string working = seed;
+        if (combinationCount <= maxOrientationChecks) {
+            getCombinations(seed, working, 0, combinations);
+        } else {
+            // too many to check: the matcher orients each hit by its bases,
+            // the first combination only sets the default
+            for (char &c : working) c = IUPAC[c].front();
+            combinations.push_back(working);
+        }
+
+        bool seedIsForward = isCloserToFwd(combinations.front(), canonicalFwd);
+        bool isMixed = std::any_of(combinations.begin(), combinations.end(),
+            [&](const std::string &combo) { return isCloserToFwd(combo, canonicalFwd) != seedIsForward; });
+
+        if (isMixed) { // orientation differs between combinations, keep them apart
+            for (const auto &combo : combinations) {
+                bool comboIsForward = isCloserToFwd(combo, canonicalFwd);
+                result.emplace_back(combo, comboIsForward);
+                result.emplace_back(revCom(combo), !comboIsForward);
+            }
+        } else {
+            result.emplace_back(seed, seedIsForward);
+            result.emplace_back(revComClasses(seed), !seedIsForward);
+        }
+    }
+
+    std::sort(result.begin(), result.end(),
+        [](const auto &a, const auto &b) { return a.first < b.first; });
+    result.erase(
+        std::unique(result.begin(), result.end(),
+            [](const auto &a, const auto &b) { return a.first == b.first; }),
+        result.end());
+
+    return result;
+}
+
+
+uint64_t countPatternVariants(
+    const std::vector<std::string> &rawPatterns,
+    uint8_t editDistance) {
+
+    auto saturatingMultiply = [](uint64_t a, uint64_t b) -> uint64_t {
+        uint64_t product;
+        return __builtin_mul_overflow(a, b, &product) ? UINT64_MAX : product;
+    };
+    auto saturatingAdd = [](uint64_t a, uint64_t b) -> uint64_t {
+        uint64_t sum;
+        return __builtin_add_overflow(a, b, &sum) ? UINT64_MAX : sum;
+    };
+
+    uint64_t total = 0;
+    for (const auto &seed : rawPatterns) {
+        uint64_t combinationCount = seed.empty() ? 0 : 1;
+        for (char c : seed) {
+            auto it = IUPAC.find(c);
+            combinationCount = saturatingMultiply(combinationCount, it == IUPAC.end() ? 0 : it->second.size());
+        }
+
+        // getEditVariants: 3L substitutions, then 3L more from each of them
+        uint64_t substitutions = 3 * seed.size();
+        uint64_t variants = 1;
+        if (editDistance >= 1) variants = saturatingAdd(variants, substitutions);
+        if (editDistance >= 2) variants = saturatingAdd(variants, saturatingMultiply(substitutions, substitutions));
+
+        total = saturatingAdd(total, saturatingMultiply(2, saturatingMultiply(combinationCount, variants)));
+    }
+    return total;
+}
+
+
+uint64_t countAutomatonStates(
+    const std::vector<std::string> &rawPatterns,
+    uint8_t editDistance) {
+
+    auto saturatingMultiply = [](uint64_t a, uint64_t b) -> uint64_t {
+        uint64_t product;
+        return __builtin_mul_overflow(a, b, &product) ? UINT64_MAX : product;
+    };
+    auto saturatingAdd = [](uint64_t a, uint64_t b) -> uint64_t {
+        uint64_t sum;
+        return __builtin_add_overflow(a, b, &sum) ? UINT64_MAX : sum;
+    };
+
+    uint64_t total = 1; // root
+    for (const auto &seed : rawPatterns) {
+        uint64_t combinationCount = 1;
+        for (size_t depth = 1; depth <= seed.size(); ++depth) {
+            auto it = IUPAC.find(seed[depth - 1]);
+            combinationCount = saturatingMultiply(combinationCount, it == IUPAC.end() ? 0 : it->second.size());
+
+            // prefixes of this depth with up to editDistance substitutions
+            uint64_t substituted = 1, choose = 1, prefixes = 1;
+            for (uint64_t k = 1; k <= editDistance && k <= depth; ++k) {
+                choose = choose * (depth - k + 1) / k;
+                substituted = saturatingMultiply(substituted, 3);
+                prefixes = saturatingAdd(prefixes, saturatingMultiply(choose, substituted));
+            }
+            total = saturatingAdd(total, saturatingMultiply(2, saturatingMultiply(combinationCount, prefixes)));
+        }
+    }
+    return total;
+}
+
+
+bool hasDegenerateSeeds(const std::vector<std::string> &rawPatterns) {
+    return std::any_of(rawPatterns.begin(), rawPatterns.end(), [](const std::string &seed) {
+        return seed.find_first_not_of("ACGT") != std::string::npos;
+    });
+}
@@ -514,4 +514,64 @@ make_filler() {
     echo "${parm}${mid1}${its_telo}${mid2}${qarm}"
 } > "$DIR/boundary_extend_its.fa"
 
+# ============================================================
+# 38. boundary_adaptive_chain.fa — p-block bridged by non-canonical repeats
+# 600bp CCCTAA, 600bp of 1-mismatch CCCTAC, 600bp CCCTAA in one chain.
+# With -t 3000 --adaptive-extent 300 the tip scan must follow the chain
+# past 600bp of no canonical match: block ends at 1800 as with the full scan.
+# ============================================================
+{
+    echo ">chr_boundary_adaptive_chain"
+    parm=$(repeat_motif "CCCTAA" 100)       # 600bp canonical at pos 0
+    ext=$(repeat_motif "CCCTAC" 100)        # 600bp non-canonical at pos 600
+    parm2=$(repeat_motif "CCCTAA" 100)      # 600bp canonical at pos 1200
+    mid=$(make_filler 6000)
+    qarm=$(repeat_motif "TTAGGG" 100)       # 600bp q-arm
+    echo "${parm}${ext}${parm2}${mid}${qarm}"
+} > "$DIR/boundary_adaptive_chain.fa"
+
+# ============================================================
+# 39. boundary_adaptive_merge.fa — Second q sub-block within blockDist
+# Two 600bp TTAGGG clusters 480bp apart (< default -d 500) at the q end.
+# With -t 3000 --adaptive-extent 300 the tip scan must reach the inner
+# cluster so both merge into one q-block as with the full scan.
+# ============================================================
+{
+    echo ">chr_boundary_adaptive_merge"
+    parm=$(repeat_motif "CCCTAA" 100)       # 600bp p-arm
+    mid=$(make_filler 6000)
+    clust1=$(repeat_motif "TTAGGG" 100)     # 600bp at pos 6600
+    gap=$(make_filler 480)                  # 480bp gap < blockDist
+    clust2=$(repeat_motif "TTAGGG" 100)     # 600bp at pos 7680
+    echo "${parm}${mid}${clust1}${gap}${clust2}"
+} > "$DIR/boundary_adaptive_merge.fa"
+
+# ============================================================
+# 40. boundary_window_levels.fa — Arrays across the -w/-s 1000 window bounds
+# Repeats straddling 1000, 3000 and 6000 fit no 1000bp window. Blocks,
+# -m matches and the report must not change with --window-levels 2000,4000.
+# ============================================================
+{
+    echo ">chr_boundary_window_levels"
+    parm=$(repeat_motif "CCCTAA" 200)       # 1200bp p-arm across 1000
+    mid1=$(make_filler 1500)
+    its_telo=$(repeat_motif "TTAGGG" 100)   # 600bp ITS at pos 2700, across 3000
+    mid2=$(make_filler 2400)
+    qarm=$(repeat_motif "TTAGGG" 134)       # 804bp q-arm at pos 5700, across 6000
+    echo "${parm}${mid1}${its_telo}${mid2}${qarm}"
+} > "$DIR/boundary_window_levels.fa"
+
+# ============================================================
+# 41. indel_test.fa — Planted 1-bp indels and an N-run (--indels -x 1)
+# Insertion TTAGCGG at 78, deletion CCCAA at 181, and truncated repeats
+# TTAGG/TAGGG on both sides of the N-run at 281-291.
+# ============================================================
+{
+    echo ">chr_indel"
+    ins="$(repeat_motif "TTAGGG" 3)TTAGCGG$(repeat_motif "TTAGGG" 3)"
+    del="$(repeat_motif "CCCTAA" 3)CCCAA$(repeat_motif "CCCTAA" 3)"
+    gap="$(repeat_motif "TTAGGG" 2)TTAGGNNNNNNNNNNTAGGG$(repeat_motif "TTAGGG" 2)"
+    echo "$(make_filler 60)${ins}$(make_filler 60)${del}$(make_filler 60)${gap}$(make_filler 60)"
+} > "$DIR/indel_test.fa"
+
 echo "Generated $(ls -1 "$DIR"/*.fa "$DIR"/*.gfa 2>/dev/null | wc -l) synthetic test files in $DIR/"
@@ -0,0 +1,179 @@
+#include "kernels.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t maxLength = 130; // two 64-byte vectors plus a tail
+constexpr uint64_t maxOffset = 3;   // unaligned starts
+
+void require(bool condition, const std::string &message) {
+    if (!condition) {
+        throw std::runtime_error(message);
+    }
+}
+
+std::vector<std::string> supportedKernels() {
+    std::vector<std::string> names;
+    std::istringstream list(kernels::supported());
+    std::string name;
+    while (std::getline(list, name, ',')) {
+        name.erase(0, name.find_first_not_of(' '));
+        names.push_back(name);
+    }
+    return names;
+}
+
+// mixed-case bases, N runs, IUPAC codes and other bytes; padded so vector
+// loads past the end stay inside the buffer
+std::string makeSequence(std::mt19937 &rng, uint64_t length) {
+    static const char alphabet[] = "ACGTACGTacgtacgtNNnRYkm-*";
+    std::string seq(length + maxOffset + 128, 'N');
+    for (uint64_t i = 0; i < seq.size(); ++i) {
+        const uint32_t pick = rng() % 64;
+        if (pick < sizeof(alphabet) - 1) seq[i] = alphabet[pick];
+        else if (pick < 60) seq[i] = "ACGT"[pick % 4];
+        else seq[i] = static_cast<char>(1 + rng() % 255);
+    }
+    return seq;
+}
+
+std::string where(const kernels::KernelSet &kernel, uint64_t offset, uint64_t length) {
+    return std::string(kernel.name) + " offset " + std::to_string(offset) + " length " + std::to_string(length);
+}
+
+void testCountBases(const kernels::KernelSet &kernel, const kernels::KernelSet &scalar, std::mt19937 &rng) {
+    for (uint64_t length = 0; length <= maxLength; ++length) {
+        const std::string seq = makeSequence(rng, length);
+        for (uint64_t offset = 0; offset <= maxOffset; ++offset) {
+            uint32_t expected[4] = {1, 2, 3, 4}, counts[4] = {1, 2, 3, 4}; // adds to the counts
+            scalar.countBases(seq.data() + offset, length, expected);
+            kernel.countBases(seq.data() + offset, length, counts);
+            require(std::memcmp(expected, counts, sizeof(counts)) == 0,
+                    "countBases differs from scalar, " + where(kernel, offset, length));
+        }
+    }
+}
+
+void testDecodeBases(const kernels::KernelSet &kernel, const kernels::KernelSet &scalar, std::mt19937 &rng) {
+    for (uint64_t length = 0; length <= maxLength; ++length) {
+        std::vector<uint8_t> packed(length / 2 + maxOffset + 1);
+        for (auto &byte : packed) byte = static_cast<uint8_t>(rng());
+        for (uint64_t offset = 0; offset <= maxOffset; ++offset) {
+            std::string expected(length + 1, '#'), decoded(length + 1, '#');
+            scalar.decodeBases(packed.data() + offset, length, &expected[0]);
+            kernel.decodeBases(packed.data() + offset, length, &decoded[0]);
+            require(expected == decoded, "decodeBases differs from scalar, " + where(kernel, offset, length));
+        }
+    }
+}
+
+void testFindAnchor(const kernels::KernelSet &kernel, const kernels::KernelSet &scalar, std::mt19937 &rng) {
+    for (uint8_t anchorLen = 1; anchorLen <= kernels::anchorStride; ++anchorLen) {
+        for (uint32_t anchorCount = 1; anchorCount <= 4; ++anchorCount) {
+            for (uint64_t length = 0; length <= maxLength; ++length) {
+                std::string seq = makeSequence(rng, length);
+                // lowercase anchors, some of them planted in either case
+                std::string anchors(anchorCount * kernels::anchorStride, '\0');
+                for (uint32_t a = 0; a < anchorCount; ++a) {
+                    for (uint8_t t = 0; t < anchorLen; ++t) anchors[a * kernels::anchorStride + t] = "acgt"[rng() % 4];
+                    if (length >= anchorLen && rng() % 2) {
+                        const uint64_t at = rng() % (length - anchorLen + 1) + maxOffset;
+                        for (uint8_t t = 0; t < anchorLen; ++t) {
+                            const char base = anchors[a * kernels::anchorStride + t];
+                            seq[at + t] = rng() % 2 ? base : static_cast<char>(base - 'a' + 'A');
+                        }
+                    }
+                }
+                for (uint64_t offset = 0; offset <= maxOffset; ++offset) {
+                    for (uint64_t pos = 0; pos <= length; pos += 1 + length / 8) {
+                        const uint64_t end = offset + length;
+                        const uint64_t expected = scalar.findAnchor(seq.data(), offset + pos, end,
+                                                                    anchors.data(), anchorCount, anchorLen);
+                        const uint64_t found = kernel.findAnchor(seq.data(), offset + pos, end,
+                                                                 anchors.data(), anchorCount, anchorLen);
+                        require(expected == found, "findAnchor differs from scalar, " + where(kernel, offset, length) +
+                                " pos " + std::to_string(pos) + " anchors " + std::to_string(anchorCount) +
+                                "x" + std::to_string(anchorLen));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void testNextBase(const kernels::KernelSet &kernel, const kernels::KernelSet &scalar, std::mt19937 &rng) {
+    for (uint64_t length = 0; length <= maxLength; ++length) {
+        std::string seq = makeSequence(rng, length);
+        // an N-run over most of the range, so the search crosses whole vectors
+        if (length > 4 && rng() % 2) {
+            const uint64_t runEnd = maxOffset + length - rng() % 4;
+            for (uint64_t i = maxOffset; i < runEnd; ++i) seq[i] = rng() % 8 ? 'N' : 'n';
+        }
+        for (uint64_t offset = 0; offset <= maxOffset; ++offset) {
+            const uint64_t end = offset + length;
+            for (uint64_t pos = offset; pos <= end; ++pos) {
+                require(scalar.nextBase(seq.data(), pos, end) == kernel.nextBase(seq.data(), pos, end),
+                        "nextBase differs from scalar, " + where(kernel, offset, length) +
+                        " pos " + std::to_string(pos - offset));
+            }
+        }
+    }
+}
+
+void testPeriodMask(const kernels::KernelSet &kernel, const kernels::KernelSet &scalar, std::mt19937 &rng) {
+    for (uint32_t period = 1; period <= 12; ++period) {
+        for (uint64_t length = 0; length <= maxLength; ++length) {
+            std::string seq = makeSequence(rng, length);
+            // a tandem stretch with the period, in mixed case, with N bytes in it
+            std::string unit(period, 'A');
+            for (char &base : unit) base = "ACGTacgt"[rng() % 8];
+            const uint64_t repeatEnd = maxOffset + length;
+            for (uint64_t i = maxOffset + rng() % (length / 2 + 1); i < repeatEnd; ++i) {
+                const char base = unit[i % period];
+                seq[i] = rng() % 16 == 0 ? 'N' : static_cast<char>(rng() % 2 ? base | 0x20 : base & ~0x20);
+            }
+            for (uint64_t offset = 0; offset <= maxOffset; ++offset) {
+                const uint64_t end = offset + length;
+                for (uint64_t pos = offset; pos <= end; ++pos) {
+                    require(scalar.periodMask(seq.data(), pos, end, period) ==
+                            kernel.periodMask(seq.data(), pos, end, period),
+                            "periodMask differs from scalar, " + where(kernel, offset, length) +
+                            " pos " + std::to_string(pos - offset) + " period " + std::to_string(period));
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    try {
+        require(kernels::select("scalar"), "scalar kernels not available");
+        const kernels::KernelSet scalar = kernels::active();
+
+        for (const std::string &name : supportedKernels()) {
+            require(kernels::select(name), "cannot select supported kernels " + name);
+            const kernels::KernelSet &kernel = kernels::active();
+            std::mt19937 rng(7);
+            testCountBases(kernel, scalar, rng);
+            testDecodeBases(kernel, scalar, rng);
+            testFindAnchor(kernel, scalar, rng);
+            testNextBase(kernel, scalar, rng);
+            testPeriodMask(kernel, scalar, rng);
+        }
+        std::cout << "PASS kernels (" << kernels::supported() << ")\n";
+        return 0;
+    } catch (const std::exception &error) {
+        std::cerr << "FAIL kernels: " << error.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,355 @@
+#include "match-store.h"
+#include "spill-file.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+void require(bool condition, const std::string &message) {
+    if (!condition) {
+        throw std::runtime_error(message);
+    }
+}
+
+// the matches a store should hold, with the bases of each
+struct Expected {
+    std::vector<MatchInfo> matches;
+    std::vector<std::string> sequences;
+};
+
+std::string upper(std::string bases) {
+    for (char &base : bases) base = static_cast<char>(std::toupper(static_cast<unsigned char>(base)));
+    return bases;
+}
+
+MatchInfo makeMatch(std::mt19937_64 &rng, uint64_t position) {
+    MatchInfo match;
+    match.position = position;
+    match.matchSize = static_cast<uint16_t>(rng() % 4 == 0 ? MatchStore::maxMatchSize - rng() % 4 : 1 + rng() % 12);
+    match.distance = static_cast<uint8_t>(rng() % (MatchStore::maxDistance + 1));
+    match.isForward = rng() % 2;
+    match.isCanonical = rng() % 2;
+    match.isReported = rng() % 2;
+    return match;
+}
+
+// soft-masked bases from a small alphabet, so sequences repeat
+std::string makeBases(std::mt19937_64 &rng, uint16_t length) {
+    std::string bases(length, 'A');
+    const char *alphabet = rng() % 2 ? "ACGTacgt" : "Tt";
+    const size_t alphabetSize = std::char_traits<char>::length(alphabet);
+    for (char &base : bases) base = alphabet[rng() % alphabetSize];
+    return bases;
+}
+
+// positions ascend by small steps, jump past 32-bit offsets and sometimes go back
+uint64_t nextPosition(std::mt19937_64 &rng, uint64_t position) {
+    switch (rng() % 16) {
+        case 0: return position + (uint64_t(1) << 32) + rng() % 1000;
+        case 1: return position > 1000 ? position - rng() % 1000 : position;
+        case 2: return position + UINT32_MAX;
+        default: return position + rng() % 50;
+    }
+}
+
+bool sameMatch(const MatchInfo &a, const MatchInfo &b) {
+    return std::tie(a.position, a.matchSize, a.distance, a.isForward, a.isCanonical, a.isReported) ==
+           std::tie(b.position, b.matchSize, b.distance, b.isForward, b.isCanonical, b.isReported);
+}
+
+std::string describe(const MatchInfo &match) {
+    return std::to_string(match.position) + "+" + std::to_string(match.matchSize) +
+           " d" + std::to_string(match.distance) + (match.isForward ? " fwd" : " rev") +
+           (match.isCanonical ? " canonical" : "") + (match.isReported ? " reported" : "");
+}
+
+void requireStore(const MatchStore &store, const Expected &expected, bool withSequences, const std::string &what) {
+    require(store.size() == expected.matches.size(),
+            what + ": " + std::to_string(store.size()) + " matches, expected " + std::to_string(expected.matches.size()));
+    for (size_t i = 0; i < store.size(); ++i) {
+        require(sameMatch(store[i], expected.matches[i]),
+                what + ": match " + std::to_string(i) + " is " + describe(store[i]) +
+                ", expected " + describe(expected.matches[i]));
+        require(store.position(i) == expected.matches[i].position, what + ": position " + std::to_string(i));
+        if (withSequences) {
+            require(store.sequence(i) == expected.sequences[i],
+                    what + ": sequence " + std::to_string(i) + " is " + store.sequence(i) +
+                    ", expected " + expected.sequences[i]);
+        }
+    }
+}
+
+Expected fill(MatchStore &store, std::mt19937_64 &rng, size_t count, bool withSequences, uint64_t position = 0) {
+    Expected expected;
+    for (size_t i = 0; i < count; ++i) {
+        position = nextPosition(rng, position);
+        const MatchInfo match = makeMatch(rng, position);
+        if (withSequences) {
+            const std::string bases = makeBases(rng, match.matchSize);
+            store.push_back(match, bases.c_str());
+            expected.sequences.push_back(upper(bases));
+        } else {
+            store.push_back(match);
+        }
+        expected.matches.push_back(match);
+    }
+    return expected;
+}
+
+void testPushBack(std::mt19937_64 &rng) {
+    for (bool withSequences : {false, true}) {
+        MatchStore store;
+        const Expected expected = fill(store, rng, 5000, withSequences);
+        requireStore(store, expected, withSequences, withSequences ? "push_back with sequences" : "push_back");
+        require(store.memoryUsage() > 0, "memoryUsage of a filled store");
+
+        store.clear();
+        require(store.empty() && store.size() == 0, "clear leaves matches");
+        const Expected refilled = fill(store, rng, 100, withSequences, uint64_t(1) << 40);
+        requireStore(store, refilled, withSequences, "push_back after clear");
+    }
+}
+
+void testViews(std::mt19937_64 &rng) {
+    MatchStore store;
+    const Expected expected = fill(store, rng, 2000, false);
+
+    struct Case {
+        const char *name;
+        MatchStore::View view;
+        bool (*contains)(const MatchInfo &);
+    };
+    const Case cases[] = {
+        {"all", store.all(), [](const MatchInfo &) { return true; }},
+        {"forward", store.forward(), [](const MatchInfo &m) { return m.isForward; }},
+        {"reverse", store.reverse(), [](const MatchInfo &m) { return !m.isForward; }},
+        {"canonical", store.canonical(), [](const MatchInfo &m) { return m.isCanonical; }},
+        {"reported", store.reported(), [](const MatchInfo &m) { return m.isReported; }},
+        {"reportedNonCanonical", store.reportedNonCanonical(),
+         [](const MatchInfo &m) { return m.isReported && !m.isCanonical; }},
+    };
+    for (const Case &c : cases) {
+        std::vector<size_t> members;
+        for (size_t i = 0; i < expected.matches.size(); ++i) {
+            if (c.contains(expected.matches[i])) members.push_back(i);
+        }
+        const std::string what = std::string("view ") + c.name;
+        require(c.view.count() == members.size(), what + ": count");
+        require(c.view.first() == (members.empty() ? MatchStore::npos : members.front()), what + ": first");
+        require(c.view.last() == (members.empty() ? MatchStore::npos : members.back()), what + ": last");
+
+        std::vector<size_t> walked;
+        for (size_t i = c.view.first(); i != MatchStore::npos; i = c.view.next(i + 1)) walked.push_back(i);
+        require(walked == members, what + ": next walk");
+        walked.clear();
+        for (size_t i = c.view.last(); i != MatchStore::npos; i = c.view.before(i)) walked.push_back(i);
+        std::reverse(walked.begin(), walked.end());
+        require(walked == members, what + ": before walk");
+        require(c.view.next(store.size()) == MatchStore::npos, what + ": next past the end");
+        require(c.view.before(0) == MatchStore::npos, what + ": before the start");
+    }
+}
+
+void testLowerBound(std::mt19937_64 &rng) {
+    MatchStore store;
+    std::vector<uint64_t> positions;
+    uint64_t position = 0;
+    for (size_t i = 0; i < 3000; ++i) {
+        position += rng() % 8 == 0 ? (uint64_t(1) << 32) + rng() % 7 : rng() % 5; // ascending, with repeats
+        MatchInfo match;
+        match.position = position;
+        match.matchSize = 6;
+        store.push_back(match);
+        positions.push_back(position);
+    }
+    for (size_t i = 0; i < 3000; ++i) {
+        const uint64_t probe = i % 3 == 0 ? positions[rng() % positions.size()] : rng() % (position + 10);
+        const size_t expected = std::lower_bound(positions.begin(), positions.end(), probe) - positions.begin();
+        require(store.lowerBound(probe) == expected, "lowerBound of " + std::to_string(probe));
+    }
+}
+
+void testSortFrom(std::mt19937_64 &rng) {
+    for (bool withSequences : {false, true}) {
+        for (size_t from : {size_t(0), size_t(1), size_t(700), size_t(1499), size_t(1500), size_t(2000)}) {
+            MatchStore store;
+            Expected expected = fill(store, rng, 1500, withSequences, uint64_t(3) << 32);
+            store.sortFrom(from);
+
+            if (from < expected.matches.size()) {
+                std::vector<size_t> order(expected.matches.size() - from);
+                for (size_t i = 0; i < order.size(); ++i) order[i] = from + i;
+                std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                    const MatchInfo &x = expected.matches[a], &y = expected.matches[b];
+                    return std::tie(x.position, x.matchSize) < std::tie(y.position, y.matchSize);
+                });
+                Expected sorted;
+                sorted.matches.assign(expected.matches.begin(), expected.matches.begin() + from);
+                if (withSequences) sorted.sequences.assign(expected.sequences.begin(), expected.sequences.begin() + from);
+                for (size_t i : order) {
+                    sorted.matches.push_back(expected.matches[i]);
+                    if (withSequences) sorted.sequences.push_back(expected.sequences[i]);
+                }
+                expected = sorted;
+            }
+            requireStore(store, expected, withSequences, "sortFrom " + std::to_string(from));
+        }
+    }
+}
+
+void testAppend(std::mt19937_64 &rng) {
+    for (bool sourceSequences : {false, true}) {
+        for (bool targetSequences : {false, true}) {
+            MatchStore source, target;
+            const Expected fromSource = fill(source, rng, 1200, sourceSequences, uint64_t(7) << 32);
+            Expected expected = fill(target, rng, 300, targetSequences);
+            expected.sequences.resize(expected.matches.size());
+
+            target.append(source.canonical());
+            for (size_t i = 0; i < fromSource.matches.size(); ++i) {
+                if (!fromSource.matches[i].isCanonical) continue;
+                expected.matches.push_back(fromSource.matches[i]);
+                if (sourceSequences) expected.sequences.push_back(fromSource.sequences[i]);
+            }
+            // ids of the target's own matches are only checked when it recorded them
+            const std::string what = std::string("append, source ") + (sourceSequences ? "with" : "without") +
+                                     " sequences, target " + (targetSequences ? "with" : "without");
+            requireStore(target, expected, false, what);
+            if (sourceSequences) {
+                for (size_t i = targetSequences ? 0 : 300; i < target.size(); ++i) {
+                    require(target.sequence(i) == expected.sequences[i], what + ": sequence " + std::to_string(i));
+                }
+            }
+        }
+    }
+}
+
+// a path spilling its matches in chunks, between chunks of other paths,
+// read back and joined with the matches it still holds, as the report does
+void testSpilledMatches(std::mt19937_64 &rng, const std::string &spillPath) {
+    for (bool withSequences : {false, true}) {
+        SpillFile spill(spillPath);
+        std::vector<SpillFile::Extent> extents;
+        Expected expected;
+        uint64_t position = 0;
+        for (size_t chunk = 0; chunk < 6; ++chunk) {
+            MatchStore held, other;
+            const Expected part = fill(held, rng, chunk == 2 ? 0 : rng() % 800, withSequences, position);
+            if (!part.matches.empty()) position = part.matches.back().position;
+            expected.matches.insert(expected.matches.end(), part.matches.begin(), part.matches.end());
+            expected.sequences.insert(expected.sequences.end(), part.sequences.begin(), part.sequences.end());
+
+            std::string bytes;
+            held.serialize(bytes);
+            extents.push_back(spill.append(bytes.data(), bytes.size()));
+            fill(other, rng, 50, !withSequences);
+            bytes.clear();
+            other.serialize(bytes);
+            spill.append(bytes.data(), bytes.size());
+        }
+        MatchStore held;
+        const Expected tail = fill(held, rng, 300, withSequences, position);
+        expected.matches.insert(expected.matches.end(), tail.matches.begin(), tail.matches.end());
+        expected.sequences.insert(expected.sequences.end(), tail.sequences.begin(), tail.sequences.end());
+
+        MatchStore restored;
+        std::vector<char> bytes;
+        for (const SpillFile::Extent &extent : extents) {
+            bytes.resize(extent.bytes);
+            spill.read(extent, bytes.data());
+            restored.deserialize(bytes.data(), bytes.size());
+        }
+        restored.append(held.all());
+        requireStore(restored, expected, withSequences,
+                     withSequences ? "spilled matches with sequences" : "spilled matches");
+    }
+}
+
+// fixed-size records appended by several threads come back per extent list
+void testSpillRecords(std::mt19937_64 &rng, const std::string &spillPath) {
+    struct Record {
+        uint32_t id;
+        uint32_t index;
+        float value;
+    };
+    constexpr uint32_t threadCount = 4, batches = 50;
+    SpillFile spill(spillPath);
+    std::vector<std::vector<SpillFile::Extent>> extents(threadCount);
+    std::vector<std::vector<Record>> written(threadCount);
+    std::vector<uint32_t> seeds(threadCount);
+    for (uint32_t &seed : seeds) seed = static_cast<uint32_t>(rng());
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 local(seeds[t]);
+            for (uint32_t batch = 0; batch < batches; ++batch) {
+                std::vector<Record> records(local() % 40); // empty batches too
+                for (Record &record : records) {
+                    record = {t, static_cast<uint32_t>(written[t].size()), static_cast<float>(local() % 1000) / 7};
+                    written[t].push_back(record);
+                }
+                extents[t].push_back(spill.append(records));
+            }
+        });
+    }
+    for (std::thread &thread : threads) thread.join();
+
+    std::vector<Record> records = {{9, 9, 9.0f}}; // replaced, not appended to
+    for (uint32_t t = 0; t < threadCount; ++t) {
+        spill.read(extents[t], records);
+        require(records.size() == written[t].size(), "spill records of thread " + std::to_string(t) + ": count");
+        for (size_t i = 0; i < records.size(); ++i) {
+            require(records[i].id == t && records[i].index == i && records[i].value == written[t][i].value,
+                    "spill records of thread " + std::to_string(t) + ": record " + std::to_string(i));
+        }
+    }
+}
+
+void testMemoryBudget() {
+    MemoryBudget unbounded;
+    require(!unbounded.bounded() && unbounded.reserve(UINT64_MAX / 2), "unbounded budget refuses a reservation");
+
+    MemoryBudget budget;
+    budget.setLimit(1000);
+    require(budget.bounded(), "bounded budget");
+    require(budget.reserve(600) && budget.reserve(400), "reservations within the limit");
+    require(!budget.reserve(1), "reservation past the limit");
+    budget.release(400);
+    require(!budget.reserve(401) && budget.reserve(400), "released bytes are reserved again");
+}
+
+} // namespace
+
+int main() {
+    try {
+        std::mt19937_64 rng(13);
+        testPushBack(rng);
+        testViews(rng);
+        testLowerBound(rng);
+        testSortFrom(rng);
+        testAppend(rng);
+
+        const std::string spillPath = (std::filesystem::temp_directory_path() /
+                                       ("teloscope_match_store_" + std::to_string(rng()) + ".spill")).string();
+        testSpilledMatches(rng, spillPath);
+        testSpillRecords(rng, spillPath);
+        require(!std::filesystem::exists(spillPath), "spill file left behind");
+        testMemoryBudget();
+        std::cout << "PASS match store and spill file\n";
+        return 0;
+    } catch (const std::exception &error) {
+        std::cerr << "FAIL match store: " << error.what() << '\n';
+        return 1;
+    }
+}